@@ -1,11 +1,50 @@
 #include <iostream>
 #include <vector>
 
-const size_t kChunkSize = 512;
+const size_t kDequePageSize = 4096;
+// целевой размер куска в байтах - страница памяти
+const size_t kDequeChunkBytes = kDequePageSize;
 
-template <typename T, typename Allocator = std::allocator<T>>
+namespace deque_detail {
+
+// наибольшая степень двойки, не превосходящая value; не меньше 1
+constexpr size_t FloorPowerOfTwo(size_t value) {
+  size_t power = 1;
+  while (power <= value / 2) {
+    power *= 2;
+  }
+  return power;
+}
+
+constexpr size_t Log2(size_t power) {
+  size_t shift = 0;
+  while (power > 1) {
+    power /= 2;
+    ++shift;
+  }
+  return shift;
+}
+
+}  // namespace deque_detail
+
+// вместимость куска считается из sizeof(T): в ChunkBytes байт входит
+// наибольшая степень двойки элементов (хотя бы один). Степень двойки
+// позволяет итератору делить и брать остаток сдвигом и маской.
+// Кусок занимает ровно kChunkSize * sizeof(T) байт; по странице он
+// выравнивается, только если его размер кратен странице, иначе
+// выравнивание увеличило бы размер выделения
+template <typename T, typename Allocator = std::allocator<T>,
+          size_t ChunkBytes = kDequeChunkBytes>
 class Deque {
  public:
+  static constexpr size_t kChunkSize =
+      deque_detail::FloorPowerOfTwo(ChunkBytes / sizeof(T));
+  static constexpr size_t kChunkShift = deque_detail::Log2(kChunkSize);
+  static constexpr size_t kChunkMask = kChunkSize - 1;
+  static constexpr size_t kChunkAlignment =
+      (kChunkSize * sizeof(T)) % kDequePageSize == 0 ? kDequePageSize
+                                                     : alignof(T);
+
   Deque();
   Deque(const Allocator& alloc);
   Deque(const Deque& other);
@@ -129,6 +168,18 @@ class Deque {
   using alloc_traits = std::allocator_traits<Allocator>;
 
  private:
+  // память куска; выравнивание задано типом, поэтому его соблюдает и
+  // аллокатор, перепривязанный к Chunk. Оно делит размер куска, так что
+  // sizeof(Chunk) == kChunkSize * sizeof(T)
+  struct alignas(kChunkAlignment) Chunk {
+    unsigned char bytes[kChunkSize * sizeof(T)];
+  };
+  static_assert(sizeof(Chunk) == kChunkSize * sizeof(T),
+                "chunk alignment must not pad the allocation");
+  using chunk_traits = typename alloc_traits::template rebind_traits<Chunk>;
+
+  T* allocate_chunk();
+  void deallocate_chunk(T* chunk);
   void clear();
   void resize(size_t count);
   std::vector<T*> map_;
@@ -139,9 +190,10 @@ class Deque {
   Allocator alloc_;
 };
 
-template <typename T, typename Allocator>
+template <typename T, typename Allocator, size_t ChunkBytes>
 template <typename... Args>
-void Deque<T, Allocator>::emplace(Deque::iterator iter, Args&&... args) {
+void Deque<T, Allocator, ChunkBytes>::emplace(Deque::iterator iter,
+                                              Args&&... args) {
   if (iter == end_) {
     emplace_back(args...);
     return;
@@ -154,13 +206,13 @@ void Deque<T, Allocator>::emplace(Deque::iterator iter, Args&&... args) {
   }
 }
 
-template <typename T, typename Allocator>
+template <typename T, typename Allocator, size_t ChunkBytes>
 template <typename... Args>
-void Deque<T, Allocator>::emplace_back(Args&&... args) {
+void Deque<T, Allocator, ChunkBytes>::emplace_back(Args&&... args) {
   if (cap_end_ == map_.size() - 1 &&
       end_.curr_elem_ + 1 == end_.curr_chunk_end_) {
     resize(map_.size() * 3);
-    map_[++cap_end_] = alloc_traits::allocate(alloc_, kChunkSize);
+    map_[++cap_end_] = allocate_chunk();
     try {
       alloc_traits::construct(alloc_, end_.curr_elem_,
                               std::forward<Args>(args)...);
@@ -174,7 +226,7 @@ void Deque<T, Allocator>::emplace_back(Args&&... args) {
   if (end_.curr_elem_ + 1 == end_.curr_chunk_end_) {
     if (cap_end_ != map_.size()) {
       ++cap_end_;
-      map_[cap_end_] = alloc_traits::allocate(alloc_, kChunkSize);
+      map_[cap_end_] = allocate_chunk();
     }
     try {
       alloc_traits::construct(alloc_, end_.curr_elem_,
@@ -194,9 +246,9 @@ void Deque<T, Allocator>::emplace_back(Args&&... args) {
   }
 }
 
-template <typename T, typename Allocator>
+template <typename T, typename Allocator, size_t ChunkBytes>
 template <typename... Args>
-void Deque<T, Allocator>::emplace_front(Args&&... args) {
+void Deque<T, Allocator, ChunkBytes>::emplace_front(Args&&... args) {
   if (cap_begin_ == 0 && begin_.curr_elem_ == begin_.curr_chunk_begin_) {
     resize(map_.size() * 3);
     try {
@@ -211,7 +263,7 @@ void Deque<T, Allocator>::emplace_front(Args&&... args) {
   }
   if (begin_.curr_elem_ == begin_.curr_chunk_begin_) {
     --cap_begin_;
-    map_[cap_begin_] = alloc_traits::allocate(alloc_, kChunkSize);
+    map_[cap_begin_] = allocate_chunk();
     try {
       --begin_;
       alloc_traits::construct(alloc_, begin_.curr_elem_,
@@ -232,8 +284,8 @@ void Deque<T, Allocator>::emplace_front(Args&&... args) {
   }
 }
 
-template <typename T, typename Allocator>
-void Deque<T, Allocator>::insert(Deque::iterator&& iter, T elem) {
+template <typename T, typename Allocator, size_t ChunkBytes>
+void Deque<T, Allocator, ChunkBytes>::insert(Deque::iterator&& iter, T elem) {
   if (iter == end_) {
     push_back(elem);
     return;
@@ -246,8 +298,8 @@ void Deque<T, Allocator>::insert(Deque::iterator&& iter, T elem) {
   }
 }
 
-template <typename T, typename Allocator>
-void Deque<T, Allocator>::erase(Deque::iterator&& iter) {
+template <typename T, typename Allocator, size_t ChunkBytes>
+void Deque<T, Allocator, ChunkBytes>::erase(Deque::iterator&& iter) {
   if (iter == end()) {
     pop_back();
     return;
@@ -259,8 +311,8 @@ void Deque<T, Allocator>::erase(Deque::iterator&& iter) {
   pop_back();
 }
 
-template <typename T, typename Allocator>
-void Deque<T, Allocator>::push_front(T&& elem) {
+template <typename T, typename Allocator, size_t ChunkBytes>
+void Deque<T, Allocator, ChunkBytes>::push_front(T&& elem) {
   if (cap_begin_ == 0 && begin_.curr_elem_ == begin_.curr_chunk_begin_) {
     resize(map_.size() * 3);
     try {
@@ -274,7 +326,7 @@ void Deque<T, Allocator>::push_front(T&& elem) {
   }
   if (begin_.curr_elem_ == begin_.curr_chunk_begin_) {
     --cap_begin_;
-    map_[cap_begin_] = alloc_traits::allocate(alloc_, kChunkSize);
+    map_[cap_begin_] = allocate_chunk();
     try {
       --begin_;
       alloc_traits::construct(alloc_, begin_.curr_elem_, std::move(elem));
@@ -293,8 +345,8 @@ void Deque<T, Allocator>::push_front(T&& elem) {
   }
 }
 
-template <typename T, typename Allocator>
-void Deque<T, Allocator>::push_front(const T& elem) {
+template <typename T, typename Allocator, size_t ChunkBytes>
+void Deque<T, Allocator, ChunkBytes>::push_front(const T& elem) {
   if (cap_begin_ == 0 && begin_.curr_elem_ == begin_.curr_chunk_begin_) {
     resize(map_.size() * 3);
     try {
@@ -308,7 +360,7 @@ void Deque<T, Allocator>::push_front(const T& elem) {
   }
   if (begin_.curr_elem_ == begin_.curr_chunk_begin_) {
     --cap_begin_;
-    map_[cap_begin_] = alloc_traits::allocate(alloc_, kChunkSize);
+    map_[cap_begin_] = allocate_chunk();
     try {
       --begin_;
       alloc_traits::construct(alloc_, begin_.curr_elem_, elem);
@@ -327,12 +379,12 @@ void Deque<T, Allocator>::push_front(const T& elem) {
   }
 }
 
-template <typename T, typename Allocator>
-void Deque<T, Allocator>::push_back(T&& elem) {
+template <typename T, typename Allocator, size_t ChunkBytes>
+void Deque<T, Allocator, ChunkBytes>::push_back(T&& elem) {
   if (cap_end_ == map_.size() - 1 &&
       end_.curr_elem_ + 1 == end_.curr_chunk_end_) {
     resize(map_.size() * 3);
-    map_[++cap_end_] = alloc_traits::allocate(alloc_, kChunkSize);
+    map_[++cap_end_] = allocate_chunk();
     try {
       alloc_traits::construct(alloc_, (end_).curr_elem_, std::move(elem));
       ++end_;
@@ -345,7 +397,7 @@ void Deque<T, Allocator>::push_back(T&& elem) {
   }
   if (end_.curr_elem_ + 1 == end_.curr_chunk_end_) {
     if (cap_end_ != map_.size()) {
-      map_[++cap_end_] = alloc_traits::allocate(alloc_, kChunkSize);
+      map_[++cap_end_] = allocate_chunk();
     }
     try {
       alloc_traits::construct(alloc_, (end_).curr_elem_, std::move(elem));
@@ -363,12 +415,12 @@ void Deque<T, Allocator>::push_back(T&& elem) {
   }
 }
 
-template <typename T, typename Allocator>
-void Deque<T, Allocator>::push_back(const T& elem) {
+template <typename T, typename Allocator, size_t ChunkBytes>
+void Deque<T, Allocator, ChunkBytes>::push_back(const T& elem) {
   if (cap_end_ == map_.size() - 1 &&
       end_.curr_elem_ + 1 == end_.curr_chunk_end_) {
     resize(map_.size() * 3);
-    map_[++cap_end_] = alloc_traits::allocate(alloc_, kChunkSize);
+    map_[++cap_end_] = allocate_chunk();
     try {
       alloc_traits::construct(alloc_, end_.curr_elem_, elem);
       ++end_;
@@ -382,7 +434,7 @@ void Deque<T, Allocator>::push_back(const T& elem) {
   if (end_.curr_elem_ + 1 == end_.curr_chunk_end_) {
     if (cap_end_ != map_.size()) {
       ++cap_end_;
-      map_[cap_end_] = alloc_traits::allocate(alloc_, kChunkSize);
+      map_[cap_end_] = allocate_chunk();
     }
     try {
       alloc_traits::construct(alloc_, end_.curr_elem_, elem);
@@ -400,32 +452,45 @@ void Deque<T, Allocator>::push_back(const T& elem) {
   }
 }
 
-template <typename T, typename Allocator>
-void Deque<T, Allocator>::clear() {
+template <typename T, typename Allocator, size_t ChunkBytes>
+T* Deque<T, Allocator, ChunkBytes>::allocate_chunk() {
+  typename chunk_traits::allocator_type chunk_alloc(alloc_);
+  return reinterpret_cast<T*>(chunk_traits::allocate(chunk_alloc, 1));
+}
+
+template <typename T, typename Allocator, size_t ChunkBytes>
+void Deque<T, Allocator, ChunkBytes>::deallocate_chunk(T* chunk) {
+  typename chunk_traits::allocator_type chunk_alloc(alloc_);
+  chunk_traits::deallocate(chunk_alloc, reinterpret_cast<Chunk*>(chunk), 1);
+}
+
+template <typename T, typename Allocator, size_t ChunkBytes>
+void Deque<T, Allocator, ChunkBytes>::clear() {
   for (size_t i = 0; i < size(); ++i) {
     alloc_traits::destroy(alloc_, &begin_[i]);
   }
   for (size_t i = cap_begin_; i <= cap_end_; ++i) {
-    alloc_traits::deallocate(alloc_, map_[i], kChunkSize);
+    deallocate_chunk(map_[i]);
   }
 }
 
-template <typename T, typename Allocator>
-void Deque<T, Allocator>::resize(size_t count) {
+template <typename T, typename Allocator, size_t ChunkBytes>
+void Deque<T, Allocator, ChunkBytes>::resize(size_t count) {
   std::vector<T*> tmp(count, nullptr);
   for (size_t i = cap_begin_; i <= cap_end_; ++i) {
     tmp[i - cap_begin_ + (count / 3)] = map_[i];
     map_[i] = nullptr;
   }
   cap_begin_ = (count / 3);
-  cap_end_ = cap_begin_ + (size() / kChunkSize);
+  cap_end_ = cap_begin_ + (size() >> kChunkShift);
   std::swap(tmp, map_);
   begin_.set_chunk(&map_[cap_begin_]);
   end_.set_chunk(&map_[cap_end_]);
 }
 
-template <typename T, typename Allocator>
-Deque<T, Allocator>& Deque<T, Allocator>::operator=(Deque&& other) {
+template <typename T, typename Allocator, size_t ChunkBytes>
+Deque<T, Allocator, ChunkBytes>& Deque<T, Allocator, ChunkBytes>::operator=(
+    Deque&& other) {
   alloc_ = alloc_traits::propagate_on_container_move_assignment::value
                ? other.alloc_
                : alloc_;
@@ -455,9 +520,9 @@ Deque<T, Allocator>& Deque<T, Allocator>::operator=(Deque&& other) {
   return *this;
 }
 
-template <typename T, typename Allocator>
-Deque<T, Allocator>& Deque<T, Allocator>::operator=(
-    const Deque<T, Allocator>& other) {
+template <typename T, typename Allocator, size_t ChunkBytes>
+Deque<T, Allocator, ChunkBytes>& Deque<T, Allocator, ChunkBytes>::operator=(
+    const Deque& other) {
   alloc_ = alloc_traits::propagate_on_container_copy_assignment::value
                ? other.alloc_
                : alloc_;
@@ -487,12 +552,12 @@ Deque<T, Allocator>& Deque<T, Allocator>::operator=(
   return *this;
 }
 
-template <typename T, typename Allocator>
-Deque<T, Allocator>::Deque(std::initializer_list<T> init,
-                           const Allocator& alloc)
+template <typename T, typename Allocator, size_t ChunkBytes>
+Deque<T, Allocator, ChunkBytes>::Deque(std::initializer_list<T> init,
+                                       const Allocator& alloc)
     : alloc_(alloc) {
   map_.resize(3, nullptr);
-  map_[1] = alloc_traits::allocate(alloc_, kChunkSize);
+  map_[1] = allocate_chunk();
   cap_begin_ = 1;
   cap_end_ = 1;
   begin_.set_chunk(&map_[1]);
@@ -504,8 +569,8 @@ Deque<T, Allocator>::Deque(std::initializer_list<T> init,
   }
 }
 
-template <typename T, typename Allocator>
-Deque<T, Allocator>::Deque(Deque&& other)
+template <typename T, typename Allocator, size_t ChunkBytes>
+Deque<T, Allocator, ChunkBytes>::Deque(Deque&& other)
     : map_(std::vector<T*>(other.map_.size(), nullptr)),
       cap_begin_(other.cap_begin_),
       cap_end_(other.cap_end_),
@@ -518,23 +583,23 @@ Deque<T, Allocator>::Deque(Deque&& other)
   other.map_.resize(3, nullptr);
   begin_ = std::move(other.begin_);
   end_ = std::move(other.end_);
-  other.map_[1] = other.get_allocator().allocate(kChunkSize);
+  other.map_[1] = other.allocate_chunk();
   other.begin_.set_chunk(&other.map_[1]);
   other.begin_.curr_elem_ = other.begin_.curr_chunk_begin_;
   other.end_.set_chunk(&other.map_[1]);
   other.end_.curr_elem_ = other.end_.curr_chunk_begin_;
 }
 
-template <typename T, typename Allocator>
-Deque<T, Allocator>::Deque(const Deque<T, Allocator>& other)
+template <typename T, typename Allocator, size_t ChunkBytes>
+Deque<T, Allocator, ChunkBytes>::Deque(const Deque& other)
     : Deque(alloc_traits::select_on_container_copy_construction(other.alloc_)) {
   for (const auto& iter : other) {
     emplace_back(iter);
   }
 }
 
-template <typename T, typename Allocator>
-Deque<T, Allocator>::Deque(size_t count, const Allocator& alloc)
+template <typename T, typename Allocator, size_t ChunkBytes>
+Deque<T, Allocator, ChunkBytes>::Deque(size_t count, const Allocator& alloc)
     : Deque(alloc) {
   for (size_t i = 0; i < count; ++i) {
     try {
@@ -545,21 +610,22 @@ Deque<T, Allocator>::Deque(size_t count, const Allocator& alloc)
   }
 }
 
-template <typename T, typename Allocator>
-Deque<T, Allocator>::Deque(size_t elem_number, const T& default_elem,
-                           const Allocator& alloc)
+template <typename T, typename Allocator, size_t ChunkBytes>
+Deque<T, Allocator, ChunkBytes>::Deque(size_t elem_number,
+                                       const T& default_elem,
+                                       const Allocator& alloc)
     : alloc_(alloc) {
-  size_t chunk_number = (elem_number / kChunkSize) + 1;
+  size_t chunk_number = (elem_number >> kChunkShift) + 1;
   map_.resize(chunk_number * 3, nullptr);
   cap_begin_ = chunk_number;
   cap_end_ = (chunk_number * 2) - 1;
   for (size_t i = cap_begin_; i <= cap_end_; ++i) {
-    map_[i] = alloc_traits::allocate(alloc_, kChunkSize);
+    map_[i] = allocate_chunk();
   }
   begin_.set_chunk(&map_[cap_begin_]);
   begin_.curr_elem_ = begin_.curr_chunk_begin_;
   end_.set_chunk(&map_[cap_end_]);
-  end_.curr_elem_ = end_.curr_chunk_begin_ + (elem_number % kChunkSize);
+  end_.curr_elem_ = end_.curr_chunk_begin_ + (elem_number & kChunkMask);
   for (auto& iter : *this) {
     try {
       alloc_traits::construct(alloc_, &iter, std::move(default_elem));
@@ -570,10 +636,10 @@ Deque<T, Allocator>::Deque(size_t elem_number, const T& default_elem,
   }
 }
 
-template <typename T, typename Allocator>
-Deque<T, Allocator>::Deque(const Allocator& alloc) : alloc_(alloc) {
+template <typename T, typename Allocator, size_t ChunkBytes>
+Deque<T, Allocator, ChunkBytes>::Deque(const Allocator& alloc) : alloc_(alloc) {
   map_.resize(3, nullptr);
-  map_[1] = alloc_traits::allocate(alloc_, kChunkSize);
+  map_[1] = allocate_chunk();
   cap_begin_ = 1;
   cap_end_ = 1;
   begin_.set_chunk(&map_[1]);
@@ -582,10 +648,10 @@ Deque<T, Allocator>::Deque(const Allocator& alloc) : alloc_(alloc) {
   end_.curr_elem_ = end_.curr_chunk_begin_;
 }
 
-template <typename T, typename Allocator>
-Deque<T, Allocator>::Deque() : alloc_(Allocator()) {
+template <typename T, typename Allocator, size_t ChunkBytes>
+Deque<T, Allocator, ChunkBytes>::Deque() : alloc_(Allocator()) {
   map_.resize(3, nullptr);
-  map_[1] = alloc_traits::allocate(alloc_, kChunkSize);
+  map_[1] = allocate_chunk();
   cap_begin_ = 1;
   cap_end_ = 1;
   begin_.set_chunk(&map_[1]);
@@ -594,94 +660,99 @@ Deque<T, Allocator>::Deque() : alloc_(Allocator()) {
   end_.curr_elem_ = end_.curr_chunk_begin_;
 }
 
-template <typename T, typename Allocator>
+template <typename T, typename Allocator, size_t ChunkBytes>
 template <bool IsConst>
-void Deque<T, Allocator>::CommonIterator<IsConst>::set_chunk(T** new_chunk) {
+void Deque<T, Allocator, ChunkBytes>::CommonIterator<IsConst>::set_chunk(
+    T** new_chunk) {
   curr_chunk_ = new_chunk;
   curr_chunk_begin_ = *curr_chunk_;
   curr_chunk_end_ = curr_chunk_begin_ + kChunkSize;
 }
 
-template <typename T, typename Allocator>
+template <typename T, typename Allocator, size_t ChunkBytes>
 template <bool IsConst>
-typename Deque<T, Allocator>::template CommonIterator<IsConst>&
-Deque<T, Allocator>::CommonIterator<IsConst>::operator+=(int64_t idx) {
+typename Deque<T, Allocator, ChunkBytes>::template CommonIterator<IsConst>&
+Deque<T, Allocator, ChunkBytes>::CommonIterator<IsConst>::operator+=(
+    int64_t idx) {
   const int64_t kOffset = idx + (curr_elem_ - curr_chunk_begin_);
   if (kOffset >= 0 && kOffset < (int64_t)kChunkSize) {
     curr_elem_ += idx;
   } else {
-    const int64_t kChunkOffset =
-        kOffset > 0 ? kOffset / kChunkSize : -((-kOffset - 1) / kChunkSize) - 1;
-    set_chunk(curr_chunk_ + kChunkOffset);
-    curr_elem_ = curr_chunk_begin_ + (kOffset - kChunkOffset * kChunkSize);
+    // арифметический сдвиг округляет вниз и для отрицательного смещения,
+    // а маска даёт неотрицательный остаток
+    set_chunk(curr_chunk_ + (kOffset >> kChunkShift));
+    curr_elem_ = curr_chunk_begin_ + (kOffset & kChunkMask);
   }
   return *this;
 }
 
-template <typename T, typename Allocator>
+template <typename T, typename Allocator, size_t ChunkBytes>
 template <bool IsConst>
-bool Deque<T, Allocator>::CommonIterator<IsConst>::operator<(
-    const Deque<T, Allocator>::CommonIterator<IsConst>& rhs) const {
+bool Deque<T, Allocator, ChunkBytes>::CommonIterator<IsConst>::operator<(
+    const CommonIterator<IsConst>& rhs) const {
   return (curr_chunk_ == rhs.curr_chunk_) ? (curr_elem_ < rhs.curr_elem_)
                                           : (curr_chunk_ < rhs.curr_chunk_);
 }
 
-template <typename T, typename Allocator>
+template <typename T, typename Allocator, size_t ChunkBytes>
 template <bool IsConst>
-bool Deque<T, Allocator>::CommonIterator<IsConst>::operator==(
-    const Deque<T, Allocator>::CommonIterator<IsConst>& rhs) const {
+bool Deque<T, Allocator, ChunkBytes>::CommonIterator<IsConst>::operator==(
+    const CommonIterator<IsConst>& rhs) const {
   return curr_chunk_ == rhs.curr_chunk_ && curr_elem_ == rhs.curr_elem_ &&
          curr_chunk_end_ == rhs.curr_chunk_end_ &&
          curr_chunk_begin_ == rhs.curr_chunk_begin_;
 }
 
-template <typename T, typename Allocator>
+template <typename T, typename Allocator, size_t ChunkBytes>
 template <bool IsConst>
-std::ptrdiff_t Deque<T, Allocator>::CommonIterator<IsConst>::operator-(
-    const Deque::CommonIterator<IsConst>& rhs) const {
-  return kChunkSize * (curr_chunk_ - rhs.curr_chunk_ - int(curr_chunk_ != 0)) +
-         (curr_elem_ - curr_chunk_begin_) +
-         (rhs.curr_chunk_end_ - rhs.curr_elem_);
+std::ptrdiff_t
+Deque<T, Allocator, ChunkBytes>::CommonIterator<IsConst>::operator-(
+    const CommonIterator<IsConst>& rhs) const {
+  return (curr_chunk_ - rhs.curr_chunk_) * std::ptrdiff_t(kChunkSize) +
+         (curr_elem_ - curr_chunk_begin_) -
+         (rhs.curr_elem_ - rhs.curr_chunk_begin_);
 }
 
-template <typename T, typename Allocator>
+template <typename T, typename Allocator, size_t ChunkBytes>
 template <bool IsConst>
-typename Deque<T, Allocator>::template CommonIterator<IsConst>
-Deque<T, Allocator>::CommonIterator<IsConst>::operator-(int64_t idx) const {
+typename Deque<T, Allocator, ChunkBytes>::template CommonIterator<IsConst>
+Deque<T, Allocator, ChunkBytes>::CommonIterator<IsConst>::operator-(
+    int64_t idx) const {
   CommonIterator<IsConst> tmp = *this;
   return tmp += -idx;
 }
 
-template <typename T, typename Allocator>
+template <typename T, typename Allocator, size_t ChunkBytes>
 template <bool IsConst>
-typename Deque<T, Allocator>::template CommonIterator<IsConst>
-Deque<T, Allocator>::CommonIterator<IsConst>::operator+(int64_t idx) const {
+typename Deque<T, Allocator, ChunkBytes>::template CommonIterator<IsConst>
+Deque<T, Allocator, ChunkBytes>::CommonIterator<IsConst>::operator+(
+    int64_t idx) const {
   CommonIterator<IsConst> tmp = *this;
   return tmp += idx;
 }
 
-template <typename T, typename Allocator>
+template <typename T, typename Allocator, size_t ChunkBytes>
 template <bool IsConst>
-typename Deque<T, Allocator>::template CommonIterator<IsConst>
-Deque<T, Allocator>::CommonIterator<IsConst>::operator--(int) {
+typename Deque<T, Allocator, ChunkBytes>::template CommonIterator<IsConst>
+Deque<T, Allocator, ChunkBytes>::CommonIterator<IsConst>::operator--(int) {
   CommonIterator<IsConst> tmp = *this;
   --*this;
   return tmp;
 }
 
-template <typename T, typename Allocator>
+template <typename T, typename Allocator, size_t ChunkBytes>
 template <bool IsConst>
-typename Deque<T, Allocator>::template CommonIterator<IsConst>
-Deque<T, Allocator>::CommonIterator<IsConst>::operator++(int) {
+typename Deque<T, Allocator, ChunkBytes>::template CommonIterator<IsConst>
+Deque<T, Allocator, ChunkBytes>::CommonIterator<IsConst>::operator++(int) {
   CommonIterator<IsConst> tmp = *this;
   ++*this;
   return tmp;
 }
 
-template <typename T, typename Allocator>
+template <typename T, typename Allocator, size_t ChunkBytes>
 template <bool IsConst>
-typename Deque<T, Allocator>::template CommonIterator<IsConst>&
-Deque<T, Allocator>::CommonIterator<IsConst>::operator--() {
+typename Deque<T, Allocator, ChunkBytes>::template CommonIterator<IsConst>&
+Deque<T, Allocator, ChunkBytes>::CommonIterator<IsConst>::operator--() {
   if (curr_elem_ == curr_chunk_begin_) {
     set_chunk(--curr_chunk_);
     curr_elem_ = curr_chunk_end_;
@@ -690,10 +761,10 @@ Deque<T, Allocator>::CommonIterator<IsConst>::operator--() {
   return *this;
 }
 
-template <typename T, typename Allocator>
+template <typename T, typename Allocator, size_t ChunkBytes>
 template <bool IsConst>
-typename Deque<T, Allocator>::template CommonIterator<IsConst>&
-Deque<T, Allocator>::CommonIterator<IsConst>::operator++() {
+typename Deque<T, Allocator, ChunkBytes>::template CommonIterator<IsConst>&
+Deque<T, Allocator, ChunkBytes>::CommonIterator<IsConst>::operator++() {
   ++curr_elem_;
   if (curr_elem_ == curr_chunk_end_) {
     set_chunk(++curr_chunk_);
@@ -0,0 +1,161 @@
+#pragma once
+
+#include <stdexcept>
+#include <vector>
+
+#include "matrix.cpp"
+
+// матрица с размерами, известными только во время выполнения;
+// хранение и ядра те же, что у Matrix
+template <typename T = int64_t>
+class DynamicMatrix {
+ public:
+  DynamicMatrix() = default;
+  DynamicMatrix(size_t rows, size_t cols, const T& elem = T());
+  DynamicMatrix(size_t rows, size_t cols, std::vector<T>&& data);
+  DynamicMatrix(const std::vector<std::vector<T>>& matrix);
+  explicit DynamicMatrix(MatrixView<T> view);
+
+  DynamicMatrix operator+(MatrixView<T> mtx_1) const {
+    DynamicMatrix<T> result(*this);
+    result += mtx_1;
+    return result;
+  }
+  DynamicMatrix operator-(MatrixView<T> mtx_1) const {
+    DynamicMatrix<T> result(*this);
+    result -= mtx_1;
+    return result;
+  }
+  DynamicMatrix operator*(const T& elem) const {
+    DynamicMatrix<T> result(*this);
+    result *= elem;
+    return result;
+  }
+  DynamicMatrix& operator+=(MatrixView<T> mtx);
+  DynamicMatrix& operator-=(MatrixView<T> mtx);
+  DynamicMatrix& operator*=(const T& elem);
+
+  DynamicMatrix Transposed() const;
+  T Trace() const;
+
+  size_t Rows() const { return rows_; }
+  size_t Cols() const { return cols_; }
+  T& operator()(const size_t kIndex1, const size_t kIndex2) {
+    return matrix_[kIndex1 * cols_ + kIndex2];
+  }
+  T operator()(const size_t kIndex1, const size_t kIndex2) const {
+    return matrix_[kIndex1 * cols_ + kIndex2];
+  }
+
+  // непрерывный буфер Rows() * Cols() элементов по строкам
+  T* Data() { return matrix_.data(); }
+  const T* Data() const { return matrix_.data(); }
+  operator MatrixView<T>() const {
+    return MatrixView<T>(Data(), rows_, cols_);
+  }
+  operator MatrixSpan<T>() { return MatrixSpan<T>(Data(), rows_, cols_); }
+  MatrixView<T> Block(size_t row, size_t col, size_t rows, size_t cols) const {
+    return MatrixView<T>(*this).Block(row, col, rows, cols);
+  }
+  MatrixSpan<T> Block(size_t row, size_t col, size_t rows, size_t cols) {
+    return MatrixSpan<T>(*this).Block(row, col, rows, cols);
+  }
+
+  bool operator==(const DynamicMatrix<T>& mtx) const {
+    return rows_ == mtx.rows_ && cols_ == mtx.cols_ && matrix_ == mtx.matrix_;
+  }
+
+ private:
+  void CheckSize(size_t rows, size_t cols) const;
+
+  size_t rows_ = 0;
+  size_t cols_ = 0;
+  std::vector<T> matrix_;
+};
+
+template <typename T>
+DynamicMatrix<T>::DynamicMatrix(size_t rows, size_t cols, const T& elem)
+    : rows_(rows), cols_(cols), matrix_(rows * cols, elem) {}
+
+// буфер забирается без копирования
+template <typename T>
+DynamicMatrix<T>::DynamicMatrix(size_t rows, size_t cols,
+                                std::vector<T>&& data)
+    : rows_(rows), cols_(cols), matrix_(std::move(data)) {
+  if (matrix_.size() != rows_ * cols_) {
+    throw std::invalid_argument("matrix size mismatch");
+  }
+}
+
+template <typename T>
+DynamicMatrix<T>::DynamicMatrix(const std::vector<std::vector<T>>& matrix)
+    : DynamicMatrix(matrix.size(), matrix.empty() ? 0 : matrix[0].size()) {
+  for (size_t i = 0; i < rows_; ++i) {
+    if (matrix[i].size() != cols_) {
+      throw std::invalid_argument("matrix rows differ in length");
+    }
+    std::copy(matrix[i].begin(), matrix[i].begin() + cols_,
+              matrix_.begin() + i * cols_);
+  }
+}
+
+template <typename T>
+DynamicMatrix<T>::DynamicMatrix(MatrixView<T> view)
+    : DynamicMatrix(view.Rows(), view.Cols()) {
+  CopyStrided(Data(), cols_, view.Data(), view.Stride(), rows_, cols_);
+}
+
+template <typename T>
+void DynamicMatrix<T>::CheckSize(size_t rows, size_t cols) const {
+  if (rows != rows_ || cols != cols_) {
+    throw std::invalid_argument("matrix size mismatch");
+  }
+}
+
+template <typename T>
+DynamicMatrix<T>& DynamicMatrix<T>::operator+=(MatrixView<T> mtx) {
+  CheckSize(mtx.Rows(), mtx.Cols());
+  AddStrided(Data(), cols_, mtx.Data(), mtx.Stride(), rows_, cols_);
+  return *this;
+}
+
+template <typename T>
+DynamicMatrix<T>& DynamicMatrix<T>::operator-=(MatrixView<T> mtx) {
+  CheckSize(mtx.Rows(), mtx.Cols());
+  SubStrided(Data(), cols_, mtx.Data(), mtx.Stride(), rows_, cols_);
+  return *this;
+}
+
+template <typename T>
+DynamicMatrix<T>& DynamicMatrix<T>::operator*=(const T& elem) {
+  ScaleStrided(Data(), cols_, elem, rows_, cols_);
+  return *this;
+}
+
+template <typename T>
+DynamicMatrix<T> DynamicMatrix<T>::Transposed() const {
+  DynamicMatrix<T> result(cols_, rows_);
+  TransposeStrided(result.Data(), rows_, Data(), cols_, rows_, cols_);
+  return result;
+}
+
+template <typename T>
+T DynamicMatrix<T>::Trace() const {
+  CheckSize(cols_, rows_);
+  T ans = T(0);
+  for (size_t i = 0; i < rows_; ++i) {
+    ans += matrix_[i * cols_ + i];
+  }
+  return ans;
+}
+
+template <typename T>
+DynamicMatrix<T> operator*(const DynamicMatrix<T>& matrix_1,
+                           const DynamicMatrix<T>& matrix_2) {
+  if (matrix_1.Cols() != matrix_2.Rows()) {
+    throw std::invalid_argument("matrix size mismatch");
+  }
+  DynamicMatrix<T> result(matrix_1.Rows(), matrix_2.Cols());
+  Multiply<T>(matrix_1, matrix_2, result);
+  return result;
+}
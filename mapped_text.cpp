@@ -0,0 +1,133 @@
+#pragma once
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <stdexcept>
+#include <string>
+
+#include "string.hpp"
+
+// подсказка ядру о порядке чтения страниц
+enum class AccessHint { kNormal, kSequential, kRandom };
+
+// текстовый файл, отображённый в память только для чтения. Байты не
+// копируются: View() смотрит прямо в страницы файла, поэтому к нему
+// применимы поиск, сравнение и Tokenizer из string.cpp
+class MappedText {
+ public:
+  explicit MappedText(const std::string& path,
+                      AccessHint hint = AccessHint::kNormal);
+  MappedText(MappedText&& other) noexcept;
+  MappedText& operator=(MappedText&& other) noexcept;
+  MappedText(const MappedText&) = delete;
+  MappedText& operator=(const MappedText&) = delete;
+  ~MappedText();
+
+  size_t Size() const { return size_; }
+  const char* Data() const { return data_; }
+  StringView View() const { return StringView(data_, size_); }
+  operator StringView() const { return View(); }
+
+ private:
+  void Unmap();
+
+  const char* data_ = "";
+  size_t size_ = 0;
+  void* mapping_ = nullptr;
+};
+
+// ленивый обход строк текста по '\n' (сам '\n' в строку не входит).
+// Перевод строки ищет memchr, который в libc векторизован под AVX2/SSE2.
+// Последняя строка без '\n' тоже выдаётся, если она не пустая
+class LineIterator {
+ public:
+  explicit LineIterator(StringView text) : rest_(text) {}
+
+  // false, когда строки закончились
+  bool Next(StringView& line);
+
+ private:
+  StringView rest_;
+};
+
+#include "mapped_text.hpp"
+
+// конструкторы
+MappedText::MappedText(const std::string& path, AccessHint hint) {
+  int fd = open(path.c_str(), O_RDONLY);
+  if (fd < 0) {
+    throw std::runtime_error("cannot open text file: " + path);
+  }
+  struct stat info;
+  if (fstat(fd, &info) != 0) {
+    close(fd);
+    throw std::runtime_error("cannot stat text file: " + path);
+  }
+  // пустой файл отобразить нельзя, он остаётся пустым взглядом
+  if (info.st_size == 0) {
+    close(fd);
+    return;
+  }
+  const size_t kSize = info.st_size;
+  void* mapping = mmap(nullptr, kSize, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (mapping == MAP_FAILED) {
+    throw std::runtime_error("cannot map text file: " + path);
+  }
+  if (hint == AccessHint::kSequential) {
+    madvise(mapping, kSize, MADV_SEQUENTIAL);
+  } else if (hint == AccessHint::kRandom) {
+    madvise(mapping, kSize, MADV_RANDOM);
+  }
+  mapping_ = mapping;
+  data_ = static_cast<const char*>(mapping);
+  size_ = kSize;
+}
+
+// правило пяти
+MappedText::MappedText(MappedText&& other) noexcept
+    : data_(other.data_), size_(other.size_), mapping_(other.mapping_) {
+  other.mapping_ = nullptr;
+  other.Unmap();
+}
+
+MappedText& MappedText::operator=(MappedText&& other) noexcept {
+  if (this == &other) {
+    return *this;
+  }
+  Unmap();
+  std::swap(data_, other.data_);
+  std::swap(size_, other.size_);
+  std::swap(mapping_, other.mapping_);
+  return *this;
+}
+
+MappedText::~MappedText() { Unmap(); }
+
+void MappedText::Unmap() {
+  if (mapping_ != nullptr) {
+    munmap(mapping_, size_);
+  }
+  mapping_ = nullptr;
+  data_ = "";
+  size_ = 0;
+}
+
+// обход строк
+bool LineIterator::Next(StringView& line) {
+  if (rest_.Empty()) {
+    return false;
+  }
+  const void* found = memchr(rest_.Data(), '\n', rest_.Size());
+  if (found == nullptr) {
+    line = rest_;
+    rest_ = StringView();
+    return true;
+  }
+  const size_t kLength = static_cast<const char*>(found) - rest_.Data();
+  line = rest_.Substr(0, kLength);
+  rest_.RemovePrefix(kLength + 1);
+  return true;
+}
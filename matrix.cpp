@@ -1,164 +1,752 @@
 #pragma once
 
 #include <algorithm>
+#include <array>
+#include <cstdint>
+#include <functional>
+#include <initializer_list>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
 #include <vector>
 
+// для матриц до kSmallMatrixDim x kSmallMatrixDim все ядра разворачиваются
+// на этапе компиляции
+const size_t kSmallMatrixDim = 4;
+
+template <size_t N, size_t M>
+constexpr bool kIsSmallMatrix = (N <= kSmallMatrixDim && M <= kSmallMatrixDim);
+
+// матрицы до kMaxInlineMatrixSize элементов хранятся прямо в объекте;
+// такие матрицы - литеральные типы и считаются в constexpr
+const size_t kMaxInlineMatrixSize = 64;
+
+template <size_t N, size_t M>
+constexpr bool kIsInlineMatrix = (N * M <= kMaxInlineMatrixSize);
+
+// элементы лежат одним блоком по строкам: (i, j) -> i * M + j
+template <size_t N, size_t M, typename T>
+using MatrixStorage = std::conditional_t<kIsInlineMatrix<N, M>,
+                                         std::array<T, N * M>, std::vector<T>>;
+
+template <size_t N, size_t M, typename T>
+constexpr MatrixStorage<N, M, T> MakeMatrixStorage(const T& elem) {
+  MatrixStorage<N, M, T> storage{};
+  if constexpr (kIsInlineMatrix<N, M>) {
+    for (size_t i = 0; i < N * M; ++i) {
+      storage[i] = elem;
+    }
+  } else {
+    storage.assign(N * M, elem);
+  }
+  return storage;
+}
+
+template <size_t N, size_t M, typename T>
+constexpr MatrixStorage<N, M, T> MakeMatrixStorage(
+    std::initializer_list<std::initializer_list<T>> matrix) {
+  MatrixStorage<N, M, T> storage = MakeMatrixStorage<N, M, T>(T());
+  size_t row = 0;
+  for (const auto& line : matrix) {
+    size_t col = 0;
+    for (const T& elem : line) {
+      storage[row * M + col++] = elem;
+    }
+    ++row;
+  }
+  return storage;
+}
+
+template <size_t N, size_t M, typename T>
+MatrixStorage<N, M, T> MakeMatrixStorage(
+    const std::vector<std::vector<T>>& matrix) {
+  if (matrix.size() != N) {
+    throw std::invalid_argument("matrix size mismatch");
+  }
+  MatrixStorage<N, M, T> storage = MakeMatrixStorage<N, M, T>(T());
+  for (size_t i = 0; i < N; ++i) {
+    if (matrix[i].size() != M) {
+      throw std::invalid_argument("matrix rows differ in length");
+    }
+    std::copy(matrix[i].begin(), matrix[i].begin() + M,
+              storage.begin() + i * M);
+  }
+  return storage;
+}
+
+// невладеющие представления подматриц: строка i начинается с data + i * stride,
+// так что блоки, строки и столбцы описываются без копирования
+template <typename T>
+class MatrixView {
+ public:
+  MatrixView() = default;
+  MatrixView(const T* data, size_t rows, size_t cols, size_t stride)
+      : data_(data), rows_(rows), cols_(cols), stride_(stride) {}
+  MatrixView(const T* data, size_t rows, size_t cols)
+      : MatrixView(data, rows, cols, cols) {}
+
+  size_t Rows() const { return rows_; }
+  size_t Cols() const { return cols_; }
+  size_t Stride() const { return stride_; }
+  const T* Data() const { return data_; }
+
+  T operator()(const size_t kIndex1, const size_t kIndex2) const {
+    return data_[kIndex1 * stride_ + kIndex2];
+  }
+
+  MatrixView Block(size_t row, size_t col, size_t rows, size_t cols) const {
+    return MatrixView(data_ + row * stride_ + col, rows, cols, stride_);
+  }
+  MatrixView Row(size_t row) const { return Block(row, 0, 1, cols_); }
+  MatrixView Col(size_t col) const { return Block(0, col, rows_, 1); }
+
+ private:
+  const T* data_ = nullptr;
+  size_t rows_ = 0;
+  size_t cols_ = 0;
+  size_t stride_ = 0;
+};
+
+template <typename T>
+class MatrixSpan {
+ public:
+  MatrixSpan() = default;
+  MatrixSpan(T* data, size_t rows, size_t cols, size_t stride)
+      : data_(data), rows_(rows), cols_(cols), stride_(stride) {}
+  MatrixSpan(T* data, size_t rows, size_t cols)
+      : MatrixSpan(data, rows, cols, cols) {}
+
+  operator MatrixView<T>() const {
+    return MatrixView<T>(data_, rows_, cols_, stride_);
+  }
+
+  size_t Rows() const { return rows_; }
+  size_t Cols() const { return cols_; }
+  size_t Stride() const { return stride_; }
+  T* Data() const { return data_; }
+
+  T& operator()(const size_t kIndex1, const size_t kIndex2) const {
+    return data_[kIndex1 * stride_ + kIndex2];
+  }
+
+  MatrixSpan Block(size_t row, size_t col, size_t rows, size_t cols) const {
+    return MatrixSpan(data_ + row * stride_ + col, rows, cols, stride_);
+  }
+  MatrixSpan Row(size_t row) const { return Block(row, 0, 1, cols_); }
+  MatrixSpan Col(size_t col) const { return Block(0, col, rows_, 1); }
+
+ private:
+  T* data_ = nullptr;
+  size_t rows_ = 0;
+  size_t cols_ = 0;
+  size_t stride_ = 0;
+};
+
 template <size_t N, size_t M, typename T = int64_t>
 class Matrix {
  private:
-  std::vector<std::vector<T>> matrix_;
+  MatrixStorage<N, M, T> matrix_;
 
  public:
-  Matrix() { matrix_.resize(N, std::vector<T>(M)); }
-  Matrix(const std::vector<std::vector<T>>& matrix) { matrix_ = matrix; }
-  Matrix(const T& elem) { matrix_.resize(N, std::vector<T>(M, elem)); }
-  Matrix(const Matrix<N, M, T>& mtx) { matrix_ = mtx.matrix_; }
+  constexpr Matrix() : matrix_(MakeMatrixStorage<N, M, T>(T())) {}
+  Matrix(const std::vector<std::vector<T>>& matrix)
+      : matrix_(MakeMatrixStorage<N, M, T>(matrix)) {}
+  constexpr Matrix(std::initializer_list<std::initializer_list<T>> matrix)
+      : matrix_(MakeMatrixStorage<N, M, T>(matrix)) {}
+  constexpr Matrix(const T& elem)
+      : matrix_(MakeMatrixStorage<N, M, T>(elem)) {}
+  constexpr Matrix(const Matrix<N, M, T>& mtx) : matrix_(mtx.matrix_) {}
+  constexpr Matrix& operator=(const Matrix<N, M, T>& mtx) = default;
 
-  Matrix operator+(const Matrix<N, M, T>& mtx_1) {
-    Matrix<N, M, T> result(matrix_);
+  constexpr Matrix operator+(const Matrix<N, M, T>& mtx_1) const {
+    Matrix<N, M, T> result(*this);
     result += mtx_1;
     return result;
   }
-  Matrix operator-(const Matrix<N, M, T>& mtx_1) {
-    Matrix<N, M, T> result(matrix_);
+  constexpr Matrix operator-(const Matrix<N, M, T>& mtx_1) const {
+    Matrix<N, M, T> result(*this);
     result -= mtx_1;
     return result;
   }
-  Matrix operator*(const T& elem) {
+  constexpr Matrix operator*(const T& elem) const {
     Matrix<N, M, T> result(*this);
     result *= elem;
     return result;
   }
-  Matrix& operator+=(const Matrix<N, M, T>& mtx);
-  Matrix& operator-=(const Matrix<N, M, T>& mtx);
-  Matrix& operator*=(const T& elem);
+  constexpr Matrix& operator+=(const Matrix<N, M, T>& mtx);
+  constexpr Matrix& operator-=(const Matrix<N, M, T>& mtx);
+  constexpr Matrix& operator*=(const T& elem);
 
-  Matrix<M, N, T> Transposed();
+  constexpr Matrix<M, N, T> Transposed() const;
 
-  T& operator()(const size_t kIndex1, const size_t kIndex2) {
-    return matrix_[kIndex1][kIndex2];
+  constexpr T& operator()(const size_t kIndex1, const size_t kIndex2) {
+    return matrix_[kIndex1 * M + kIndex2];
   }
-  T operator()(const size_t kIndex1, const size_t kIndex2) const {
-    return matrix_[kIndex1][kIndex2];
+  constexpr T operator()(const size_t kIndex1, const size_t kIndex2) const {
+    return matrix_[kIndex1 * M + kIndex2];
   }
 
+  // непрерывный буфер N * M элементов по строкам
+  constexpr T* Data() { return matrix_.data(); }
+  constexpr const T* Data() const { return matrix_.data(); }
+  operator MatrixView<T>() const { return MatrixView<T>(Data(), N, M); }
+  operator MatrixSpan<T>() { return MatrixSpan<T>(Data(), N, M); }
+
   bool operator==(const Matrix<N, M, T>& mtx) { return matrix_ == mtx.matrix_; }
 };
 
 template <size_t N, typename T>
 class Matrix<N, N, T> {
  private:
-  std::vector<std::vector<T>> matrix_;
+  MatrixStorage<N, N, T> matrix_;
 
  public:
-  Matrix() { matrix_.resize(N, std::vector<T>(N)); }
-  Matrix(const std::vector<std::vector<T>>& matrix) { matrix_ = matrix; }
-  Matrix(const T& elem) { matrix_.resize(N, std::vector<T>(N, elem)); }
-  Matrix(const Matrix<N, N, T>& mtx) { matrix_ = mtx.matrix_; }
+  constexpr Matrix() : matrix_(MakeMatrixStorage<N, N, T>(T())) {}
+  Matrix(const std::vector<std::vector<T>>& matrix)
+      : matrix_(MakeMatrixStorage<N, N, T>(matrix)) {}
+  constexpr Matrix(std::initializer_list<std::initializer_list<T>> matrix)
+      : matrix_(MakeMatrixStorage<N, N, T>(matrix)) {}
+  constexpr Matrix(const T& elem)
+      : matrix_(MakeMatrixStorage<N, N, T>(elem)) {}
+  constexpr Matrix(const Matrix<N, N, T>& mtx) : matrix_(mtx.matrix_) {}
+  constexpr Matrix& operator=(const Matrix<N, N, T>& mtx) = default;
 
-  Matrix operator+(const Matrix<N, N, T>& mtx_1) {
-    Matrix<N, N, T> result(matrix_);
+  constexpr Matrix operator+(const Matrix<N, N, T>& mtx_1) const {
+    Matrix<N, N, T> result(*this);
     result += mtx_1;
     return result;
   }
-  Matrix operator-(const Matrix<N, N, T>& mtx_1) {
-    Matrix<N, N, T> result(matrix_);
+  constexpr Matrix operator-(const Matrix<N, N, T>& mtx_1) const {
+    Matrix<N, N, T> result(*this);
     result -= mtx_1;
     return result;
   }
-  Matrix operator*(const T& elem) {
+  constexpr Matrix operator*(const T& elem) const {
     Matrix<N, N, T> result(*this);
     result *= elem;
     return result;
   }
-  Matrix& operator+=(const Matrix<N, N, T>& mtx);
-  Matrix& operator-=(const Matrix<N, N, T>& mtx);
-  Matrix& operator*=(const T& elem);
+  constexpr Matrix& operator+=(const Matrix<N, N, T>& mtx);
+  constexpr Matrix& operator-=(const Matrix<N, N, T>& mtx);
+  constexpr Matrix& operator*=(const T& elem);
+
+  constexpr Matrix<N, N, T> Transposed() const;
+  constexpr T Trace() const;
 
-  Matrix<N, N, T> Transposed();
-  T Trace() const;
+  // только для N <= kSmallMatrixDim, считаются по явным формулам без ветвлений
+  constexpr T Determinant() const;
+  // матрица должна быть обратимой, T - поле (double, ModInt): у целых
+  // типов деление на определитель теряло бы дробную часть
+  constexpr Matrix<N, N, T> Inverted() const;
 
-  T& operator()(const size_t kIndex1, const size_t kIndex2) {
-    return matrix_[kIndex1][kIndex2];
+  constexpr T& operator()(const size_t kIndex1, const size_t kIndex2) {
+    return matrix_[kIndex1 * N + kIndex2];
   }
-  T operator()(const size_t kIndex1, const size_t kIndex2) const {
-    return matrix_[kIndex1][kIndex2];
+  constexpr T operator()(const size_t kIndex1, const size_t kIndex2) const {
+    return matrix_[kIndex1 * N + kIndex2];
   }
 
+  // непрерывный буфер N * N элементов по строкам
+  constexpr T* Data() { return matrix_.data(); }
+  constexpr const T* Data() const { return matrix_.data(); }
+  operator MatrixView<T>() const { return MatrixView<T>(Data(), N, N); }
+  operator MatrixSpan<T>() { return MatrixSpan<T>(Data(), N, N); }
+
   bool operator==(const Matrix<N, N, T>& mtx) { return matrix_ == mtx.matrix_; }
 };
 
-template <size_t N, size_t M, typename T>
-Matrix<N, M, T>& Matrix<N, M, T>::operator+=(const Matrix<N, M, T>& mtx) {
-  for (size_t i = 0; i < N; ++i) {
-    for (size_t j = 0; j < M; ++j) {
-      matrix_[i][j] += mtx.matrix_[i][j];
+// ядра над непрерывными буферами
+/* общие: произвольные размеры, строки лежат с шагом stride элементов */
+template <typename T>
+constexpr void AddStrided(T* dst, size_t dst_stride, const T* src,
+                          size_t src_stride, size_t rows, size_t cols) {
+  for (size_t i = 0; i < rows; ++i) {
+    for (size_t j = 0; j < cols; ++j) {
+      dst[i * dst_stride + j] += src[i * src_stride + j];
     }
   }
-  return *this;
 }
 
-template <size_t N, size_t M, typename T>
-Matrix<N, M, T>& Matrix<N, M, T>::operator-=(const Matrix<N, M, T>& mtx) {
-  for (size_t i = 0; i < N; ++i) {
-    for (size_t j = 0; j < M; ++j) {
-      matrix_[i][j] -= mtx.matrix_[i][j];
+template <typename T>
+constexpr void SubStrided(T* dst, size_t dst_stride, const T* src,
+                          size_t src_stride, size_t rows, size_t cols) {
+  for (size_t i = 0; i < rows; ++i) {
+    for (size_t j = 0; j < cols; ++j) {
+      dst[i * dst_stride + j] -= src[i * src_stride + j];
+    }
+  }
+}
+
+template <typename T>
+constexpr void ScaleStrided(T* dst, size_t dst_stride, const T& elem,
+                            size_t rows, size_t cols) {
+  for (size_t i = 0; i < rows; ++i) {
+    for (size_t j = 0; j < cols; ++j) {
+      dst[i * dst_stride + j] *= elem;
+    }
+  }
+}
+
+template <typename T>
+void CopyStrided(T* dst, size_t dst_stride, const T* src, size_t src_stride,
+                 size_t rows, size_t cols) {
+  for (size_t i = 0; i < rows; ++i) {
+    std::copy(src + i * src_stride, src + i * src_stride + cols,
+              dst + i * dst_stride);
+  }
+}
+
+/* src размера rows x cols, dst размера cols x rows */
+template <typename T>
+constexpr void TransposeStrided(T* dst, size_t dst_stride, const T* src,
+                                size_t src_stride, size_t rows,
+                                size_t cols) {
+  for (size_t i = 0; i < rows; ++i) {
+    for (size_t j = 0; j < cols; ++j) {
+      dst[j * dst_stride + i] = src[i * src_stride + j];
     }
   }
+}
+
+/* lhs размера rows x inner, rhs - inner x cols, dst - rows x cols */
+template <typename T>
+constexpr void MultiplyStrided(T* dst, size_t dst_stride, const T* lhs,
+                               size_t lhs_stride, const T* rhs,
+                               size_t rhs_stride, size_t rows, size_t inner,
+                               size_t cols) {
+  for (size_t i = 0; i < rows; ++i) {
+    for (size_t j = 0; j < cols; ++j) {
+      dst[i * dst_stride + j] = T();
+    }
+    for (size_t k = 0; k < inner; ++k) {
+      const T kElem = lhs[i * lhs_stride + k];
+      for (size_t j = 0; j < cols; ++j) {
+        dst[i * dst_stride + j] += kElem * rhs[k * rhs_stride + j];
+      }
+    }
+  }
+}
+
+/* поэлементные: для маленьких матриц развёрнуты через index_sequence */
+template <typename T, size_t... Idx>
+constexpr void AddKernel(T* dst, const T* src, std::index_sequence<Idx...>) {
+  ((dst[Idx] += src[Idx]), ...);
+}
+
+template <typename T, size_t... Idx>
+constexpr void SubKernel(T* dst, const T* src, std::index_sequence<Idx...>) {
+  ((dst[Idx] -= src[Idx]), ...);
+}
+
+template <typename T, size_t... Idx>
+constexpr void ScaleKernel(T* dst, const T& elem, std::index_sequence<Idx...>) {
+  ((dst[Idx] *= elem), ...);
+}
+
+template <size_t Size, typename T>
+constexpr void AddKernel(T* dst, const T* src) {
+  if constexpr (Size <= kSmallMatrixDim * kSmallMatrixDim) {
+    AddKernel(dst, src, std::make_index_sequence<Size>());
+  } else {
+    AddStrided(dst, Size, src, Size, 1, Size);
+  }
+}
+
+template <size_t Size, typename T>
+constexpr void SubKernel(T* dst, const T* src) {
+  if constexpr (Size <= kSmallMatrixDim * kSmallMatrixDim) {
+    SubKernel(dst, src, std::make_index_sequence<Size>());
+  } else {
+    SubStrided(dst, Size, src, Size, 1, Size);
+  }
+}
+
+template <size_t Size, typename T>
+constexpr void ScaleKernel(T* dst, const T& elem) {
+  if constexpr (Size <= kSmallMatrixDim * kSmallMatrixDim) {
+    ScaleKernel(dst, elem, std::make_index_sequence<Size>());
+  } else {
+    ScaleStrided(dst, Size, elem, 1, Size);
+  }
+}
+
+/* транспонирование: src размера N x M, dst размера M x N */
+template <size_t N, size_t M, typename T, size_t... Idx>
+constexpr void TransposeKernel(const T* src, T* dst,
+                               std::index_sequence<Idx...>) {
+  ((dst[Idx] = src[(Idx % N) * M + Idx / N]), ...);
+}
+
+template <size_t N, size_t M, typename T>
+constexpr void TransposeKernel(const T* src, T* dst) {
+  if constexpr (kIsSmallMatrix<N, M>) {
+    TransposeKernel<N, M>(src, dst, std::make_index_sequence<N * M>());
+  } else {
+    TransposeStrided(dst, N, src, M, N, M);
+  }
+}
+
+/* умножение: lhs размера N x M, rhs размера M x U, dst размера N x U */
+template <size_t U, typename T, size_t... K>
+constexpr T DotKernel(const T* row, const T* col, std::index_sequence<K...>) {
+  return (T() + ... + (row[K] * col[K * U]));
+}
+
+template <size_t M, size_t U, typename T, size_t... Idx>
+constexpr void MultiplyKernel(const T* lhs, const T* rhs, T* dst,
+                              std::index_sequence<Idx...>) {
+  ((dst[Idx] = DotKernel<U>(lhs + (Idx / U) * M, rhs + Idx % U,
+                            std::make_index_sequence<M>())),
+   ...);
+}
+
+template <size_t N, size_t M, size_t U, typename T>
+constexpr void MultiplyKernel(const T* lhs, const T* rhs, T* dst) {
+  if constexpr (kIsSmallMatrix<N, M> && kIsSmallMatrix<M, U>) {
+    MultiplyKernel<M, U>(lhs, rhs, dst, std::make_index_sequence<N * U>());
+  } else {
+    MultiplyStrided(dst, U, lhs, M, rhs, U, N, M, U);
+  }
+}
+
+template <size_t N, size_t M, typename T>
+constexpr Matrix<N, M, T>& Matrix<N, M, T>::operator+=(
+    const Matrix<N, M, T>& mtx) {
+  AddKernel<N * M>(Data(), mtx.Data());
+  return *this;
+}
+
+template <size_t N, typename T>
+constexpr Matrix<N, N, T>& Matrix<N, N, T>::operator+=(
+    const Matrix<N, N, T>& mtx) {
+  AddKernel<N * N>(Data(), mtx.Data());
   return *this;
 }
 
 template <size_t N, size_t M, typename T>
-Matrix<M, N, T> Matrix<N, M, T>::Transposed() {
+constexpr Matrix<N, M, T>& Matrix<N, M, T>::operator-=(
+    const Matrix<N, M, T>& mtx) {
+  SubKernel<N * M>(Data(), mtx.Data());
+  return *this;
+}
+
+template <size_t N, typename T>
+constexpr Matrix<N, N, T>& Matrix<N, N, T>::operator-=(
+    const Matrix<N, N, T>& mtx) {
+  SubKernel<N * N>(Data(), mtx.Data());
+  return *this;
+}
+
+template <size_t N, size_t M, typename T>
+constexpr Matrix<M, N, T> Matrix<N, M, T>::Transposed() const {
   Matrix<M, N, T> result;
-  for (size_t i = 0; i < N; ++i) {
-    for (size_t j = 0; j < M; ++j) {
-      result(j, i) = matrix_[i][j];
-    }
-  }
+  TransposeKernel<N, M>(Data(), result.Data());
   return result;
 }
 
 template <size_t N, typename T>
-Matrix<N, N, T> Matrix<N, N, T>::Transposed() {
+constexpr Matrix<N, N, T> Matrix<N, N, T>::Transposed() const {
   Matrix<N, N, T> result;
-  for (size_t i = 0; i < N; ++i) {
-    for (size_t j = 0; j < N; ++j) {
-      result(j, i) = matrix_[i][j];
-    }
-  }
+  TransposeKernel<N, N>(Data(), result.Data());
   return result;
 }
 
 template <size_t N, typename T>
-T Matrix<N, N, T>::Trace() const {
+constexpr T Matrix<N, N, T>::Trace() const {
   T ans = T(0);
   for (size_t i = 0; i < N; ++i) {
-    ans += matrix_[i][i];
+    ans += matrix_[i * N + i];
   }
   return ans;
 }
 
-template <size_t N, size_t M, typename T>
-Matrix<N, M, T>& Matrix<N, M, T>::operator*=(const T& elem) {
-  for (size_t i = 0; i < N; ++i) {
-    for (size_t j = 0; j < M; ++j) {
-      matrix_[i][j] *= elem;
-    }
+template <size_t N, typename T>
+constexpr T Matrix<N, N, T>::Determinant() const {
+  static_assert(N <= kSmallMatrixDim, "Determinant is only unrolled up to 4x4");
+  const T* a_m = Data();
+  if constexpr (N == 0) {
+    return T(1);
+  } else if constexpr (N == 1) {
+    return a_m[0];
+  } else if constexpr (N == 2) {
+    return a_m[0] * a_m[3] - a_m[1] * a_m[2];
+  } else if constexpr (N == 3) {
+    return a_m[0] * (a_m[4] * a_m[8] - a_m[5] * a_m[7]) -
+           a_m[1] * (a_m[3] * a_m[8] - a_m[5] * a_m[6]) +
+           a_m[2] * (a_m[3] * a_m[7] - a_m[4] * a_m[6]);
+  } else {
+    // разложение Лапласа по двум верхним строкам
+    const T kS0 = a_m[0] * a_m[5] - a_m[4] * a_m[1];
+    const T kS1 = a_m[0] * a_m[6] - a_m[4] * a_m[2];
+    const T kS2 = a_m[0] * a_m[7] - a_m[4] * a_m[3];
+    const T kS3 = a_m[1] * a_m[6] - a_m[5] * a_m[2];
+    const T kS4 = a_m[1] * a_m[7] - a_m[5] * a_m[3];
+    const T kS5 = a_m[2] * a_m[7] - a_m[6] * a_m[3];
+    const T kC5 = a_m[10] * a_m[15] - a_m[14] * a_m[11];
+    const T kC4 = a_m[9] * a_m[15] - a_m[13] * a_m[11];
+    const T kC3 = a_m[9] * a_m[14] - a_m[13] * a_m[10];
+    const T kC2 = a_m[8] * a_m[15] - a_m[12] * a_m[11];
+    const T kC1 = a_m[8] * a_m[14] - a_m[12] * a_m[10];
+    const T kC0 = a_m[8] * a_m[13] - a_m[12] * a_m[9];
+    return kS0 * kC5 - kS1 * kC4 + kS2 * kC3 + kS3 * kC2 - kS4 * kC1 +
+           kS5 * kC0;
   }
+}
+
+template <size_t N, typename T>
+constexpr Matrix<N, N, T> Matrix<N, N, T>::Inverted() const {
+  static_assert(N >= 1 && N <= kSmallMatrixDim,
+                "Inverted is only unrolled up to 4x4");
+  static_assert(!std::is_integral_v<T>,
+                "Inverted needs a field type such as double or ModInt");
+  const T* a_m = Data();
+  Matrix<N, N, T> result;
+  T* b_m = result.Data();
+  if constexpr (N == 1) {
+    b_m[0] = T(1) / a_m[0];
+    return result;
+  } else if constexpr (N == 2) {
+    b_m[0] = a_m[3];
+    b_m[1] = -a_m[1];
+    b_m[2] = -a_m[2];
+    b_m[3] = a_m[0];
+  } else if constexpr (N == 3) {
+    b_m[0] = a_m[4] * a_m[8] - a_m[5] * a_m[7];
+    b_m[1] = a_m[2] * a_m[7] - a_m[1] * a_m[8];
+    b_m[2] = a_m[1] * a_m[5] - a_m[2] * a_m[4];
+    b_m[3] = a_m[5] * a_m[6] - a_m[3] * a_m[8];
+    b_m[4] = a_m[0] * a_m[8] - a_m[2] * a_m[6];
+    b_m[5] = a_m[2] * a_m[3] - a_m[0] * a_m[5];
+    b_m[6] = a_m[3] * a_m[7] - a_m[4] * a_m[6];
+    b_m[7] = a_m[1] * a_m[6] - a_m[0] * a_m[7];
+    b_m[8] = a_m[0] * a_m[4] - a_m[1] * a_m[3];
+  } else {
+    const T kS0 = a_m[0] * a_m[5] - a_m[4] * a_m[1];
+    const T kS1 = a_m[0] * a_m[6] - a_m[4] * a_m[2];
+    const T kS2 = a_m[0] * a_m[7] - a_m[4] * a_m[3];
+    const T kS3 = a_m[1] * a_m[6] - a_m[5] * a_m[2];
+    const T kS4 = a_m[1] * a_m[7] - a_m[5] * a_m[3];
+    const T kS5 = a_m[2] * a_m[7] - a_m[6] * a_m[3];
+    const T kC5 = a_m[10] * a_m[15] - a_m[14] * a_m[11];
+    const T kC4 = a_m[9] * a_m[15] - a_m[13] * a_m[11];
+    const T kC3 = a_m[9] * a_m[14] - a_m[13] * a_m[10];
+    const T kC2 = a_m[8] * a_m[15] - a_m[12] * a_m[11];
+    const T kC1 = a_m[8] * a_m[14] - a_m[12] * a_m[10];
+    const T kC0 = a_m[8] * a_m[13] - a_m[12] * a_m[9];
+    b_m[0] = a_m[5] * kC5 - a_m[6] * kC4 + a_m[7] * kC3;
+    b_m[1] = -a_m[1] * kC5 + a_m[2] * kC4 - a_m[3] * kC3;
+    b_m[2] = a_m[13] * kS5 - a_m[14] * kS4 + a_m[15] * kS3;
+    b_m[3] = -a_m[9] * kS5 + a_m[10] * kS4 - a_m[11] * kS3;
+    b_m[4] = -a_m[4] * kC5 + a_m[6] * kC2 - a_m[7] * kC1;
+    b_m[5] = a_m[0] * kC5 - a_m[2] * kC2 + a_m[3] * kC1;
+    b_m[6] = -a_m[12] * kS5 + a_m[14] * kS2 - a_m[15] * kS1;
+    b_m[7] = a_m[8] * kS5 - a_m[10] * kS2 + a_m[11] * kS1;
+    b_m[8] = a_m[4] * kC4 - a_m[5] * kC2 + a_m[7] * kC0;
+    b_m[9] = -a_m[0] * kC4 + a_m[1] * kC2 - a_m[3] * kC0;
+    b_m[10] = a_m[12] * kS4 - a_m[13] * kS2 + a_m[15] * kS0;
+    b_m[11] = -a_m[8] * kS4 + a_m[9] * kS2 - a_m[11] * kS0;
+    b_m[12] = -a_m[4] * kC3 + a_m[5] * kC1 - a_m[6] * kC0;
+    b_m[13] = a_m[0] * kC3 - a_m[1] * kC1 + a_m[2] * kC0;
+    b_m[14] = -a_m[12] * kS3 + a_m[13] * kS1 - a_m[14] * kS0;
+    b_m[15] = a_m[8] * kS3 - a_m[9] * kS1 + a_m[10] * kS0;
+  }
+  const T kDet = Determinant();
+  for (size_t i = 0; i < N * N; ++i) {
+    b_m[i] /= kDet;
+  }
+  return result;
+}
+
+template <size_t N, size_t M, typename T>
+constexpr Matrix<N, M, T>& Matrix<N, M, T>::operator*=(const T& elem) {
+  ScaleKernel<N * M>(Data(), elem);
+  return *this;
+}
+
+template <size_t N, typename T>
+constexpr Matrix<N, N, T>& Matrix<N, N, T>::operator*=(const T& elem) {
+  ScaleKernel<N * N>(Data(), elem);
   return *this;
 }
 
 template <size_t N, size_t M, size_t U, typename T>
-Matrix<N, U, T> operator*(const Matrix<N, M, T>& matrix_1,
-                          const Matrix<M, U, T>& matrix_2) {
+constexpr Matrix<N, U, T> operator*(const Matrix<N, M, T>& matrix_1,
+                                    const Matrix<M, U, T>& matrix_2) {
   Matrix<N, U, T> result;
-  for (size_t i = 0; i < N; ++i) {
-    for (size_t j = 0; j < U; ++j) {
-      for (size_t k = 0; k < M; ++k) {
-        result(i, j) += matrix_1(i, k) * matrix_2(k, j);
+  MultiplyKernel<N, M, U>(matrix_1.Data(), matrix_2.Data(), result.Data());
+  return result;
+}
+
+// result[i] = lhs[i] * rhs[i] для i < count, без промежуточных объектов
+template <size_t N, size_t M, size_t U, typename T>
+void MultiplyBatch(const Matrix<N, M, T>* lhs, const Matrix<M, U, T>* rhs,
+                   Matrix<N, U, T>* result, size_t count) {
+  for (size_t i = 0; i < count; ++i) {
+    MultiplyKernel<N, M, U>(lhs[i].Data(), rhs[i].Data(), result[i].Data());
+  }
+}
+
+// dst = lhs * rhs для произвольных представлений; dst не должен
+// пересекаться с операндами
+template <typename T>
+void Multiply(MatrixView<T> lhs, MatrixView<T> rhs, MatrixSpan<T> dst) {
+  if (lhs.Cols() != rhs.Rows() || lhs.Rows() != dst.Rows() ||
+      rhs.Cols() != dst.Cols()) {
+    throw std::invalid_argument("matrix size mismatch");
+  }
+  MultiplyStrided(dst.Data(), dst.Stride(), lhs.Data(), lhs.Stride(),
+                  rhs.Data(), rhs.Stride(), lhs.Rows(), lhs.Cols(),
+                  rhs.Cols());
+}
+
+// GEMM в стиле BLAS: dst = alpha * op(lhs) * op(rhs) + beta * dst,
+// где op - транспонирование или ничего. Транспонированные операнды
+// читаются на месте, результат пишется в готовый dst без выделений.
+// dst не должен пересекаться с операндами, иначе std::invalid_argument
+enum class Transpose { kNo, kYes };
+
+// есть ли общие элементы у двух блоков rows x cols с шагом stride >= cols.
+// Непересекающиеся диапазоны адресов отсекаются сразу, иначе строки
+// обоих блоков, упорядоченные по адресу, сливаются за O(rows)
+template <typename T>
+bool StridedOverlap(const T* lhs, size_t lhs_rows, size_t lhs_cols,
+                    size_t lhs_stride, const T* rhs, size_t rhs_rows,
+                    size_t rhs_cols, size_t rhs_stride) {
+  if (lhs_rows == 0 || lhs_cols == 0 || rhs_rows == 0 || rhs_cols == 0) {
+    return false;
+  }
+  // std::less сравнивает и указатели на разные объекты
+  const std::less<const T*> kLess;
+  if (!kLess(lhs, rhs + (rhs_rows - 1) * rhs_stride + rhs_cols) ||
+      !kLess(rhs, lhs + (lhs_rows - 1) * lhs_stride + lhs_cols)) {
+    return false;
+  }
+  size_t i = 0;
+  size_t j = 0;
+  while (i < lhs_rows && j < rhs_rows) {
+    const T* lhs_row = lhs + i * lhs_stride;
+    const T* rhs_row = rhs + j * rhs_stride;
+    if (kLess(lhs_row, rhs_row + rhs_cols) &&
+        kLess(rhs_row, lhs_row + lhs_cols)) {
+      return true;
+    }
+    if (kLess(lhs_row + lhs_cols, rhs_row + rhs_cols)) {
+      ++i;
+    } else {
+      ++j;
+    }
+  }
+  return false;
+}
+
+/* op(lhs) размера rows x inner, op(rhs) размера inner x cols */
+template <typename T>
+void GemmStrided(const T& alpha, const T* lhs, size_t lhs_stride,
+                 Transpose lhs_op, const T* rhs, size_t rhs_stride,
+                 Transpose rhs_op, const T& beta, T* dst, size_t dst_stride,
+                 size_t rows, size_t inner, size_t cols) {
+  const bool kLhsNo = (lhs_op == Transpose::kNo);
+  const bool kRhsNo = (rhs_op == Transpose::kNo);
+  if (StridedOverlap<T>(dst, rows, cols, dst_stride, lhs,
+                        kLhsNo ? rows : inner, kLhsNo ? inner : rows,
+                        lhs_stride) ||
+      StridedOverlap<T>(dst, rows, cols, dst_stride, rhs,
+                        kRhsNo ? inner : cols, kRhsNo ? cols : inner,
+                        rhs_stride)) {
+    throw std::invalid_argument("gemm output overlaps an operand");
+  }
+  for (size_t i = 0; i < rows; ++i) {
+    T* dst_row = dst + i * dst_stride;
+    if (beta == T()) {
+      std::fill(dst_row, dst_row + cols, T());
+    } else if (beta != T(1)) {
+      for (size_t j = 0; j < cols; ++j) {
+        dst_row[j] *= beta;
       }
     }
   }
-  return result;
+  if (rhs_op == Transpose::kNo) {
+    // по j идём подряд по строке rhs
+    for (size_t i = 0; i < rows; ++i) {
+      T* dst_row = dst + i * dst_stride;
+      for (size_t k = 0; k < inner; ++k) {
+        const T kElem = alpha * (lhs_op == Transpose::kNo
+                                     ? lhs[i * lhs_stride + k]
+                                     : lhs[k * lhs_stride + i]);
+        const T* rhs_row = rhs + k * rhs_stride;
+        for (size_t j = 0; j < cols; ++j) {
+          dst_row[j] += kElem * rhs_row[j];
+        }
+      }
+    }
+    return;
+  }
+  // rhs транспонирована: строка rhs - это столбец op(rhs)
+  for (size_t i = 0; i < rows; ++i) {
+    T* dst_row = dst + i * dst_stride;
+    for (size_t j = 0; j < cols; ++j) {
+      const T* rhs_row = rhs + j * rhs_stride;
+      T sum = T();
+      if (lhs_op == Transpose::kNo) {
+        const T* lhs_row = lhs + i * lhs_stride;
+        for (size_t k = 0; k < inner; ++k) {
+          sum += lhs_row[k] * rhs_row[k];
+        }
+      } else {
+        for (size_t k = 0; k < inner; ++k) {
+          sum += lhs[k * lhs_stride + i] * rhs_row[k];
+        }
+      }
+      dst_row[j] += alpha * sum;
+    }
+  }
+}
+
+template <typename T>
+void Gemm(const T& alpha, MatrixView<T> lhs, Transpose lhs_op,
+          MatrixView<T> rhs, Transpose rhs_op, const T& beta,
+          MatrixSpan<T> dst) {
+  const size_t kRows = (lhs_op == Transpose::kNo) ? lhs.Rows() : lhs.Cols();
+  const size_t kInner = (lhs_op == Transpose::kNo) ? lhs.Cols() : lhs.Rows();
+  const size_t kRhsInner =
+      (rhs_op == Transpose::kNo) ? rhs.Rows() : rhs.Cols();
+  const size_t kCols = (rhs_op == Transpose::kNo) ? rhs.Cols() : rhs.Rows();
+  if (kInner != kRhsInner || kRows != dst.Rows() || kCols != dst.Cols()) {
+    throw std::invalid_argument("matrix size mismatch");
+  }
+  GemmStrided(alpha, lhs.Data(), lhs.Stride(), lhs_op, rhs.Data(),
+              rhs.Stride(), rhs_op, beta, dst.Data(), dst.Stride(), kRows,
+              kInner, kCols);
+}
+
+/* варианты для Matrix: размеры проверяются на этапе компиляции */
+template <size_t N, size_t M, size_t U, typename T>
+void Gemm(const T& alpha, const Matrix<N, M, T>& lhs,
+          const Matrix<M, U, T>& rhs, const T& beta, Matrix<N, U, T>& dst) {
+  GemmStrided(alpha, lhs.Data(), M, Transpose::kNo, rhs.Data(), U,
+              Transpose::kNo, beta, dst.Data(), U, N, M, U);
+}
+
+// dst = alpha * lhs^T * rhs + beta * dst
+template <size_t N, size_t M, size_t U, typename T>
+void GemmTN(const T& alpha, const Matrix<M, N, T>& lhs,
+            const Matrix<M, U, T>& rhs, const T& beta, Matrix<N, U, T>& dst) {
+  GemmStrided(alpha, lhs.Data(), N, Transpose::kYes, rhs.Data(), U,
+              Transpose::kNo, beta, dst.Data(), U, N, M, U);
+}
+
+// dst = alpha * lhs * rhs^T + beta * dst
+template <size_t N, size_t M, size_t U, typename T>
+void GemmNT(const T& alpha, const Matrix<N, M, T>& lhs,
+            const Matrix<U, M, T>& rhs, const T& beta, Matrix<N, U, T>& dst) {
+  GemmStrided(alpha, lhs.Data(), M, Transpose::kNo, rhs.Data(), M,
+              Transpose::kYes, beta, dst.Data(), U, N, M, U);
+}
+
+// dst = alpha * lhs^T * rhs^T + beta * dst
+template <size_t N, size_t M, size_t U, typename T>
+void GemmTT(const T& alpha, const Matrix<M, N, T>& lhs,
+            const Matrix<U, M, T>& rhs, const T& beta, Matrix<N, U, T>& dst) {
+  GemmStrided(alpha, lhs.Data(), N, Transpose::kYes, rhs.Data(), M,
+              Transpose::kYes, beta, dst.Data(), U, N, M, U);
 }
@@ -0,0 +1,254 @@
+#pragma once
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+
+#include "matrix.cpp"
+
+// бинарный формат: заголовок, нули до data_offset, элементы по строкам.
+// data_offset кратен alignment, поэтому данные в отображённом файле
+// выровнены так же, как в памяти. Числа пишутся в порядке байтов
+// машины, и byte_order позволяет отвергнуть файл с другим порядком
+const char kMatrixFileMagic[8] = {'M', 'T', 'X', 'B', 'I', 'N', '2', '\0'};
+const uint64_t kMatrixFileAlignment = 64;
+const uint32_t kMatrixFileByteOrder = 0x01020304;
+
+struct MatrixFileHeader {
+  char magic[8];
+  uint64_t rows;
+  uint64_t cols;
+  uint32_t elem_size;
+  uint32_t elem_type;
+  uint64_t alignment;
+  uint64_t data_offset;
+  uint32_t byte_order;
+  uint32_t reserved;
+};
+
+// код типа элемента в заголовке; 0 - произвольный тривиальный тип
+template <typename T>
+constexpr uint32_t MatrixElementCode() {
+  if constexpr (std::is_floating_point_v<T>) {
+    return 0x100 + sizeof(T);
+  } else if constexpr (std::is_integral_v<T> && std::is_signed_v<T>) {
+    return 0x200 + sizeof(T);
+  } else if constexpr (std::is_integral_v<T>) {
+    return 0x300 + sizeof(T);
+  } else {
+    return 0;
+  }
+}
+
+// пишет матрицу в поток построчно, не собирая её целиком в памяти.
+// После последних строк нужно вызвать Finish: он проверяет, что строк
+// записано столько, сколько объявлено в заголовке
+template <typename T>
+class MatrixWriter {
+ public:
+  MatrixWriter(std::ostream& out, size_t rows, size_t cols);
+
+  // дописывает очередные строки; их ширина должна совпадать с cols
+  void WriteRows(MatrixView<T> rows);
+  void Finish() const;
+
+ private:
+  std::ostream& out_;
+  size_t rows_;
+  size_t cols_;
+  size_t written_ = 0;
+};
+
+template <typename T>
+MatrixWriter<T>::MatrixWriter(std::ostream& out, size_t rows, size_t cols)
+    : out_(out), rows_(rows), cols_(cols) {
+  static_assert(std::is_trivially_copyable_v<T>,
+                "binary matrix format needs trivially copyable elements");
+  MatrixFileHeader header{};
+  memcpy(header.magic, kMatrixFileMagic, sizeof(header.magic));
+  header.rows = rows;
+  header.cols = cols;
+  header.elem_size = sizeof(T);
+  header.elem_type = MatrixElementCode<T>();
+  header.alignment = std::max<uint64_t>(kMatrixFileAlignment, alignof(T));
+  header.data_offset = header.alignment;
+  header.byte_order = kMatrixFileByteOrder;
+  out_.write(reinterpret_cast<const char*>(&header), sizeof(header));
+  for (size_t i = sizeof(header); i < header.data_offset; ++i) {
+    out_.put('\0');
+  }
+}
+
+template <typename T>
+void MatrixWriter<T>::WriteRows(MatrixView<T> rows) {
+  if (rows.Cols() != cols_ || rows.Rows() > rows_ - written_) {
+    throw std::invalid_argument("matrix size mismatch");
+  }
+  for (size_t i = 0; i < rows.Rows(); ++i) {
+    out_.write(reinterpret_cast<const char*>(rows.Data() + i * rows.Stride()),
+               cols_ * sizeof(T));
+  }
+  written_ += rows.Rows();
+}
+
+template <typename T>
+void MatrixWriter<T>::Finish() const {
+  if (written_ != rows_) {
+    throw std::invalid_argument("matrix rows missing");
+  }
+}
+
+template <typename T>
+void WriteMatrix(std::ostream& out, MatrixView<T> mtx) {
+  MatrixWriter<T> writer(out, mtx.Rows(), mtx.Cols());
+  writer.WriteRows(mtx);
+  writer.Finish();
+}
+
+template <typename T>
+void SaveMatrix(const std::string& path, MatrixView<T> mtx) {
+  std::ofstream out(path, std::ios::binary | std::ios::trunc);
+  if (!out) {
+    throw std::runtime_error("cannot open matrix file: " + path);
+  }
+  WriteMatrix(out, mtx);
+  if (!out.flush()) {
+    throw std::runtime_error("cannot write matrix file: " + path);
+  }
+}
+
+// файл, отображённый в память только для чтения; данные не копируются,
+// страницы подгружаются при первом обращении
+template <typename T>
+class MappedMatrix {
+ public:
+  explicit MappedMatrix(const std::string& path);
+  MappedMatrix(MappedMatrix&& other) noexcept;
+  MappedMatrix& operator=(MappedMatrix&& other) noexcept;
+  MappedMatrix(const MappedMatrix&) = delete;
+  MappedMatrix& operator=(const MappedMatrix&) = delete;
+  ~MappedMatrix();
+
+  size_t Rows() const { return rows_; }
+  size_t Cols() const { return cols_; }
+  const T* Data() const { return data_; }
+  T operator()(const size_t kIndex1, const size_t kIndex2) const {
+    return data_[kIndex1 * cols_ + kIndex2];
+  }
+  operator MatrixView<T>() const {
+    return MatrixView<T>(data_, rows_, cols_);
+  }
+
+ private:
+  void Unmap();
+
+  void* mapping_ = nullptr;
+  size_t length_ = 0;
+  const T* data_ = nullptr;
+  size_t rows_ = 0;
+  size_t cols_ = 0;
+};
+
+template <typename T>
+MappedMatrix<T>::MappedMatrix(const std::string& path) {
+  int fd = open(path.c_str(), O_RDONLY);
+  if (fd < 0) {
+    throw std::runtime_error("cannot open matrix file: " + path);
+  }
+  struct stat info;
+  if (fstat(fd, &info) != 0 ||
+      static_cast<size_t>(info.st_size) < sizeof(MatrixFileHeader)) {
+    close(fd);
+    throw std::runtime_error("bad matrix file: " + path);
+  }
+  length_ = info.st_size;
+  mapping_ = mmap(nullptr, length_, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (mapping_ == MAP_FAILED) {
+    mapping_ = nullptr;
+    throw std::runtime_error("cannot map matrix file: " + path);
+  }
+  MatrixFileHeader header;
+  memcpy(&header, mapping_, sizeof(header));
+  const bool kValid =
+      memcmp(header.magic, kMatrixFileMagic, sizeof(header.magic)) == 0 &&
+      header.elem_size == sizeof(T) &&
+      header.elem_type == MatrixElementCode<T>() &&
+      header.byte_order == kMatrixFileByteOrder &&
+      header.alignment != 0 && header.alignment % alignof(T) == 0 &&
+      header.data_offset % header.alignment == 0 &&
+      header.data_offset >= sizeof(MatrixFileHeader) &&
+      header.data_offset <= length_ &&
+      (header.cols == 0 ||
+       header.rows <= (length_ - header.data_offset) / sizeof(T) / header.cols);
+  if (!kValid) {
+    Unmap();
+    throw std::runtime_error("bad matrix file: " + path);
+  }
+  rows_ = header.rows;
+  cols_ = header.cols;
+  data_ = reinterpret_cast<const T*>(static_cast<const char*>(mapping_) +
+                                     header.data_offset);
+}
+
+template <typename T>
+MappedMatrix<T>::MappedMatrix(MappedMatrix&& other) noexcept
+    : mapping_(other.mapping_),
+      length_(other.length_),
+      data_(other.data_),
+      rows_(other.rows_),
+      cols_(other.cols_) {
+  other.mapping_ = nullptr;
+  other.Unmap();
+}
+
+template <typename T>
+MappedMatrix<T>& MappedMatrix<T>::operator=(MappedMatrix&& other) noexcept {
+  if (this == &other) {
+    return *this;
+  }
+  Unmap();
+  std::swap(mapping_, other.mapping_);
+  std::swap(length_, other.length_);
+  std::swap(data_, other.data_);
+  std::swap(rows_, other.rows_);
+  std::swap(cols_, other.cols_);
+  return *this;
+}
+
+template <typename T>
+MappedMatrix<T>::~MappedMatrix() {
+  Unmap();
+}
+
+template <typename T>
+void MappedMatrix<T>::Unmap() {
+  if (mapping_ != nullptr) {
+    munmap(mapping_, length_);
+  }
+  mapping_ = nullptr;
+  length_ = 0;
+  data_ = nullptr;
+  rows_ = 0;
+  cols_ = 0;
+}
+
+// копирует файл в Matrix; размеры в файле должны совпадать с N x M
+template <size_t N, size_t M, typename T = int64_t>
+Matrix<N, M, T> LoadMatrix(const std::string& path) {
+  MappedMatrix<T> mapped(path);
+  if (mapped.Rows() != N || mapped.Cols() != M) {
+    throw std::invalid_argument("matrix size mismatch");
+  }
+  Matrix<N, M, T> result;
+  std::copy(mapped.Data(), mapped.Data() + N * M, result.Data());
+  return result;
+}
@@ -0,0 +1,161 @@
+#pragma once
+
+#include <cstdint>
+#include <iostream>
+
+#include "matrix.cpp"
+
+using WideUint = unsigned __int128;
+
+// вычет по модулю P < 2^32: произведение двух вычетов помещается в uint64_t,
+// а сумма любого числа произведений - в 128 бит. Деление заменено
+// редукцией Барретта
+template <uint64_t P>
+class ModInt {
+  static_assert(P > 1 && P < (1ULL << 32), "modulus must be below 2^32");
+
+ public:
+  // конструкторы
+  constexpr ModInt() = default;
+  constexpr ModInt(int64_t value)
+      : value_(value >= 0 ? static_cast<uint64_t>(value) % P
+                          : (P - (0 - static_cast<uint64_t>(value)) % P) % P) {}
+
+  // value < 2^64 -> value mod P
+  static constexpr uint64_t Reduce(uint64_t value) {
+    const uint64_t kQuot =
+        static_cast<uint64_t>((static_cast<WideUint>(value) * kBarrett) >> 64);
+    const uint64_t kRem = value - kQuot * P;
+    return kRem >= P ? kRem - P : kRem;
+  }
+  // value < 2^128 -> value mod P
+  static constexpr uint64_t Reduce(WideUint value) {
+    const uint64_t kHigh = Reduce(static_cast<uint64_t>(value >> 64));
+    const uint64_t kLow = Reduce(static_cast<uint64_t>(value));
+    return Reduce(kHigh * kPow64 + kLow);
+  }
+  // значение, уже лежащее в [0, P), без проверок
+  static constexpr ModInt FromReduced(uint64_t value) {
+    ModInt result;
+    result.value_ = value;
+    return result;
+  }
+
+  constexpr uint64_t Value() const { return value_; }
+
+  // арифметика
+  constexpr ModInt& operator+=(const ModInt& other) {
+    value_ += other.value_;
+    value_ = value_ >= P ? value_ - P : value_;
+    return *this;
+  }
+  constexpr ModInt& operator-=(const ModInt& other) {
+    value_ += P - other.value_;
+    value_ = value_ >= P ? value_ - P : value_;
+    return *this;
+  }
+  constexpr ModInt& operator*=(const ModInt& other) {
+    value_ = Reduce(value_ * other.value_);
+    return *this;
+  }
+  constexpr ModInt& operator/=(const ModInt& other) {
+    return *this *= other.Inverse();
+  }
+  constexpr ModInt operator+(const ModInt& other) const {
+    return ModInt(*this) += other;
+  }
+  constexpr ModInt operator-(const ModInt& other) const {
+    return ModInt(*this) -= other;
+  }
+  constexpr ModInt operator*(const ModInt& other) const {
+    return ModInt(*this) *= other;
+  }
+  constexpr ModInt operator/(const ModInt& other) const {
+    return ModInt(*this) /= other;
+  }
+  constexpr ModInt operator-() const { return ModInt() - *this; }
+
+  constexpr ModInt Pow(uint64_t power) const;
+  // по малой теореме Ферма, P должен быть простым
+  constexpr ModInt Inverse() const { return Pow(P - 2); }
+
+  constexpr bool operator==(const ModInt& other) const {
+    return value_ == other.value_;
+  }
+  constexpr bool operator!=(const ModInt& other) const {
+    return value_ != other.value_;
+  }
+
+ private:
+  static constexpr uint64_t kBarrett = ~0ULL / P;        // floor((2^64-1)/P)
+  static constexpr uint64_t kPow64 = (~0ULL % P + 1) % P;  // 2^64 mod P
+
+  uint64_t value_ = 0;
+};
+
+template <uint64_t P>
+constexpr ModInt<P> ModInt<P>::Pow(uint64_t power) const {
+  ModInt result(1);
+  ModInt base = *this;
+  while (power != 0) {
+    if ((power & 1) != 0) {
+      result *= base;
+    }
+    base *= base;
+    power >>= 1;
+  }
+  return result;
+}
+
+template <uint64_t P>
+std::ostream& operator<<(std::ostream& os_out, const ModInt<P>& value) {
+  return os_out << value.Value();
+}
+
+// ядра Matrix для ModInt: произведения копятся в 128 битах без редукции,
+// а редуцируется только готовая сумма. Находятся через ADL при
+// инстанцировании ядер matrix.cpp
+template <size_t U, uint64_t P, size_t... K>
+constexpr ModInt<P> DotKernel(const ModInt<P>* row, const ModInt<P>* col,
+                              std::index_sequence<K...>) {
+  const WideUint kSum =
+      (WideUint(0) + ... +
+       static_cast<WideUint>(row[K].Value() * col[K * U].Value()));
+  return ModInt<P>::FromReduced(ModInt<P>::Reduce(kSum));
+}
+
+// столбцы результата идут блоками по kModIntBlock: суммы блока лежат на
+// стеке, поэтому умножение ничего не выделяет, обход rhs остаётся
+// построчным, а ядро годится для constexpr
+const size_t kModIntBlock = 32;
+
+template <uint64_t P>
+constexpr void MultiplyStrided(ModInt<P>* dst, size_t dst_stride,
+                               const ModInt<P>* lhs, size_t lhs_stride,
+                               const ModInt<P>* rhs, size_t rhs_stride,
+                               size_t rows, size_t inner, size_t cols) {
+  for (size_t i = 0; i < rows; ++i) {
+    for (size_t begin = 0; begin < cols; begin += kModIntBlock) {
+      const size_t kWidth = std::min(kModIntBlock, cols - begin);
+      WideUint acc[kModIntBlock] = {};
+      for (size_t k = 0; k < inner; ++k) {
+        const uint64_t kElem = lhs[i * lhs_stride + k].Value();
+        const ModInt<P>* rhs_row = rhs + k * rhs_stride + begin;
+        for (size_t j = 0; j < kWidth; ++j) {
+          acc[j] += kElem * rhs_row[j].Value();
+        }
+      }
+      for (size_t j = 0; j < kWidth; ++j) {
+        dst[i * dst_stride + begin + j] =
+            ModInt<P>::FromReduced(ModInt<P>::Reduce(acc[j]));
+      }
+    }
+  }
+}
+
+// inline-матрицы больше 4x4 умножаются через MultiplyStrided, и это
+// тоже должно считаться на этапе компиляции
+static_assert((Matrix<5, 5, ModInt<7>>(ModInt<7>(3)) *
+               Matrix<5, 5, ModInt<7>>(ModInt<7>(2)))(4, 4)
+                  .Value() == 3 * 2 * 5 % 7,
+              "ModInt matrix product must be constexpr");
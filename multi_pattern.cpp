@@ -0,0 +1,175 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+
+#include "string.hpp"
+
+// одно вхождение: номер шаблона и позиция его начала в тексте (в потоке -
+// от начала всего потока)
+struct PatternMatch {
+  size_t pattern;
+  size_t begin;
+};
+
+// автомат Ахо-Корасик по набору шаблонов: все вхождения всех шаблонов
+// находятся за один проход по тексту. Переходы хранятся плотной таблицей
+// состояние x класс байта, где классы - различные байты шаблонов плюс
+// один общий класс для остальных, так что таблица остаётся маленькой
+class MultiPatternMatcher {
+ public:
+  // пустые шаблоны игнорируются, повторы сообщаются под каждым номером
+  explicit MultiPatternMatcher(const std::vector<StringView>& patterns);
+
+  size_t PatternCount() const { return pattern_size_.size(); }
+  size_t StateCount() const { return fail_.size(); }
+
+  // on_match(pattern, begin) для каждого вхождения в порядке их концов
+  template <typename Func>
+  void Scan(StringView text, Func on_match) const;
+  std::vector<PatternMatch> FindAll(StringView text) const;
+  bool ContainsAny(StringView text) const;
+
+ private:
+  friend class MatchStream;
+
+  static constexpr uint32_t kNoState = UINT32_MAX;
+
+  uint32_t Step(uint32_t state, char character) const {
+    return next_[state * classes_ + byte_class_[uint8_t(character)]];
+  }
+  // прогоняет автомат по куску, offset - позиция куска в потоке
+  template <typename Func>
+  uint32_t Run(uint32_t state, StringView chunk, size_t offset,
+               Func& on_match) const;
+
+  uint16_t byte_class_[256] = {};  // все 256 байт дают 257 классов
+  size_t classes_ = 1;
+  std::vector<uint32_t> next_;          // StateCount() * classes_ переходов
+  std::vector<uint32_t> fail_;          // суффиксные ссылки
+  std::vector<uint32_t> output_;        // ближайшее терминальное по fail_
+  std::vector<uint32_t> terminal_;      // шаблон, кончающийся в состоянии
+  std::vector<size_t> pattern_size_;
+  std::vector<uint32_t> same_pattern_;  // следующий шаблон с тем же текстом
+};
+
+// поиск по тексту, приходящему кусками: состояние автомата переносится
+// между вызовами Feed, поэтому вхождения на стыке кусков не теряются
+class MatchStream {
+ public:
+  explicit MatchStream(const MultiPatternMatcher& matcher)
+      : matcher_(&matcher) {}
+
+  template <typename Func>
+  void Feed(StringView chunk, Func on_match) {
+    state_ = matcher_->Run(state_, chunk, offset_, on_match);
+    offset_ += chunk.Size();
+  }
+  void Reset() {
+    state_ = 0;
+    offset_ = 0;
+  }
+  size_t Offset() const { return offset_; }
+
+ private:
+  const MultiPatternMatcher* matcher_;
+  uint32_t state_ = 0;
+  size_t offset_ = 0;
+};
+
+template <typename Func>
+void MultiPatternMatcher::Scan(StringView text, Func on_match) const {
+  Run(0, text, 0, on_match);
+}
+
+template <typename Func>
+uint32_t MultiPatternMatcher::Run(uint32_t state, StringView chunk,
+                                  size_t offset, Func& on_match) const {
+  for (size_t i = 0; i < chunk.Size(); ++i) {
+    state = Step(state, chunk[i]);
+    for (uint32_t out = output_[state]; out != kNoState;
+         out = output_[fail_[out]]) {
+      for (uint32_t id = terminal_[out]; id != kNoState;
+           id = same_pattern_[id]) {
+        on_match(size_t(id), offset + i + 1 - pattern_size_[id]);
+      }
+    }
+  }
+  return state;
+}
+
+#include "multi_pattern.hpp"
+
+// конструктор: бор по шаблонам, затем обход в ширину достраивает
+// переходы по суффиксным ссылкам
+MultiPatternMatcher::MultiPatternMatcher(
+    const std::vector<StringView>& patterns)
+    : pattern_size_(patterns.size()), same_pattern_(patterns.size(), kNoState) {
+  for (StringView pattern : patterns) {
+    for (char character : pattern) {
+      uint16_t& cls = byte_class_[uint8_t(character)];
+      if (cls == 0) {
+        cls = classes_++;
+      }
+    }
+  }
+  next_.assign(classes_, 0);
+  terminal_.assign(1, kNoState);
+  for (size_t id = 0; id < patterns.size(); ++id) {
+    pattern_size_[id] = patterns[id].Size();
+    if (patterns[id].Empty()) {
+      continue;
+    }
+    uint32_t state = 0;
+    for (char character : patterns[id]) {
+      const size_t kEdge = state * classes_ + byte_class_[uint8_t(character)];
+      if (next_[kEdge] == 0) {
+        next_[kEdge] = terminal_.size();
+        terminal_.push_back(kNoState);
+        next_.resize(next_.size() + classes_, 0);
+      }
+      state = next_[kEdge];
+    }
+    same_pattern_[id] = terminal_[state];
+    terminal_[state] = id;
+  }
+
+  fail_.assign(terminal_.size(), 0);
+  output_.assign(terminal_.size(), kNoState);
+  std::vector<uint32_t> queue(1, 0);
+  for (size_t head = 0; head < queue.size(); ++head) {
+    const uint32_t kState = queue[head];
+    const uint32_t kFail = fail_[kState];
+    for (size_t cls = 0; cls < classes_; ++cls) {
+      uint32_t& child = next_[kState * classes_ + cls];
+      // у корня kFail == kState: недостающие переходы ведут в корень
+      const uint32_t kFallback = next_[kFail * classes_ + cls];
+      if (child == 0) {
+        child = kState == 0 ? 0 : kFallback;
+        continue;
+      }
+      fail_[child] = kState == 0 ? 0 : kFallback;
+      output_[child] =
+          terminal_[child] != kNoState ? child : output_[fail_[child]];
+      queue.push_back(child);
+    }
+  }
+}
+
+std::vector<PatternMatch> MultiPatternMatcher::FindAll(StringView text) const {
+  std::vector<PatternMatch> result;
+  Scan(text, [&result](size_t pattern, size_t begin) {
+    result.push_back({pattern, begin});
+  });
+  return result;
+}
+
+bool MultiPatternMatcher::ContainsAny(StringView text) const {
+  uint32_t state = 0;
+  for (char character : text) {
+    state = Step(state, character);
+    if (output_[state] != kNoState) {
+      return true;
+    }
+  }
+  return false;
+}
@@ -0,0 +1,266 @@
+#pragma once
+#include <cstdint>
+#include <memory>
+
+#include "string.hpp"
+
+const size_t kRopeLeafSize = 512;  // соседние листы короче сливаются
+
+// строка для больших редактируемых текстов: AVL-дерево неизменяемых узлов
+// с текстом в листьях. Конкатенация, срез, вставка и удаление стоят
+// O(log n), узлы разделяются между копиями, поэтому копирование O(1)
+class Rope {
+ public:
+  Rope() = default;
+  explicit Rope(StringView str);
+
+  size_t Size() const { return Size(root_); }
+  bool Empty() const { return root_ == nullptr; }
+  char operator[](size_t k_index) const;
+
+  Rope operator+(const Rope& other) const;
+  Rope& operator+=(const Rope& other);
+  // count обрезается по концу строки
+  Rope Substr(size_t pos, size_t count = SIZE_MAX) const;
+  void Insert(size_t pos, const Rope& other);
+  void Erase(size_t pos, size_t count);
+
+  String ToString() const;
+  // func(StringView) для каждого листа слева направо
+  template <typename Func>
+  void ForEachChunk(Func func) const {
+    ForEachChunk(root_, func);
+  }
+
+ private:
+  struct Node;
+  using NodePtr = std::shared_ptr<const Node>;
+
+  explicit Rope(NodePtr root) : root_(std::move(root)) {}
+
+  static size_t Size(const NodePtr& node);
+  static int Height(const NodePtr& node);
+  static NodePtr MakeLeaf(StringView str);
+  static NodePtr MakeNode(NodePtr left, NodePtr right);
+  static NodePtr Build(StringView str);
+  static NodePtr RotateLeft(const NodePtr& node);
+  static NodePtr RotateRight(const NodePtr& node);
+  static NodePtr Join(const NodePtr& left, const NodePtr& right);
+  static NodePtr JoinRight(const NodePtr& left, const NodePtr& right);
+  static NodePtr JoinLeft(const NodePtr& left, const NodePtr& right);
+  // [0, pos) и [pos, Size)
+  static void Split(const NodePtr& node, size_t pos, NodePtr& left,
+                    NodePtr& right);
+  template <typename Func>
+  static void ForEachChunk(const NodePtr& node, Func& func);
+
+  NodePtr root_;
+};
+
+// лист: непустой text, детей нет, height == 1
+struct Rope::Node {
+  NodePtr left;
+  NodePtr right;
+  String text;
+  size_t size;
+  int height;
+};
+
+template <typename Func>
+void Rope::ForEachChunk(const NodePtr& node, Func& func) {
+  if (node == nullptr) {
+    return;
+  }
+  if (node->left == nullptr) {
+    func(StringView(node->text));
+    return;
+  }
+  ForEachChunk(node->left, func);
+  ForEachChunk(node->right, func);
+}
+
+#include "rope.hpp"
+
+// конструкторы
+Rope::Rope(StringView str) : root_(Build(str)) {}
+
+// доступ
+char Rope::operator[](size_t k_index) const {
+  const Node* node = root_.get();
+  while (node->left != nullptr) {
+    if (k_index < node->left->size) {
+      node = node->left.get();
+    } else {
+      k_index -= node->left->size;
+      node = node->right.get();
+    }
+  }
+  return node->text[k_index];
+}
+
+String Rope::ToString() const {
+  StringBuilder builder;
+  ForEachChunk([&builder](StringView chunk) { builder.Append(chunk); });
+  return builder.Build();
+}
+
+// редактирование
+Rope Rope::operator+(const Rope& other) const {
+  return Rope(Join(root_, other.root_));
+}
+
+Rope& Rope::operator+=(const Rope& other) {
+  root_ = Join(root_, other.root_);
+  return *this;
+}
+
+Rope Rope::Substr(size_t pos, size_t count) const {
+  NodePtr prefix;
+  NodePtr rest;
+  Split(root_, pos, prefix, rest);
+  NodePtr middle;
+  NodePtr suffix;
+  Split(rest, std::min(count, Size(rest)), middle, suffix);
+  return Rope(middle);
+}
+
+void Rope::Insert(size_t pos, const Rope& other) {
+  NodePtr left;
+  NodePtr right;
+  Split(root_, pos, left, right);
+  root_ = Join(Join(left, other.root_), right);
+}
+
+void Rope::Erase(size_t pos, size_t count) {
+  NodePtr left;
+  NodePtr rest;
+  Split(root_, pos, left, rest);
+  NodePtr middle;
+  NodePtr right;
+  Split(rest, std::min(count, Size(rest)), middle, right);
+  root_ = Join(left, right);
+}
+
+// вспомогательные методы
+size_t Rope::Size(const NodePtr& node) {
+  return node == nullptr ? 0 : node->size;
+}
+
+int Rope::Height(const NodePtr& node) {
+  return node == nullptr ? 0 : node->height;
+}
+
+Rope::NodePtr Rope::MakeLeaf(StringView str) {
+  if (str.Empty()) {
+    return nullptr;
+  }
+  return std::make_shared<const Node>(Node{nullptr, nullptr, String(str),
+                                           str.Size(), 1});
+}
+
+Rope::NodePtr Rope::MakeNode(NodePtr left, NodePtr right) {
+  const size_t kSize = left->size + right->size;
+  const int kHeight = std::max(left->height, right->height) + 1;
+  return std::make_shared<const Node>(
+      Node{std::move(left), std::move(right), String(), kSize, kHeight});
+}
+
+// сбалансированное дерево над листами по kRopeLeafSize байт
+Rope::NodePtr Rope::Build(StringView str) {
+  if (str.Size() <= kRopeLeafSize) {
+    return MakeLeaf(str);
+  }
+  const size_t kLeaves = (str.Size() + kRopeLeafSize - 1) / kRopeLeafSize;
+  const size_t kMiddle = kLeaves / 2 * kRopeLeafSize;
+  return MakeNode(Build(str.Substr(0, kMiddle)), Build(str.Substr(kMiddle)));
+}
+
+Rope::NodePtr Rope::RotateLeft(const NodePtr& node) {
+  const NodePtr& right = node->right;
+  return MakeNode(MakeNode(node->left, right->left), right->right);
+}
+
+Rope::NodePtr Rope::RotateRight(const NodePtr& node) {
+  const NodePtr& left = node->left;
+  return MakeNode(left->left, MakeNode(left->right, node->right));
+}
+
+// склейка AVL-деревьев за O(|высота left - высота right|)
+Rope::NodePtr Rope::Join(const NodePtr& left, const NodePtr& right) {
+  if (left == nullptr) {
+    return right;
+  }
+  if (right == nullptr) {
+    return left;
+  }
+  if (left->height > right->height + 1) {
+    return JoinRight(left, right);
+  }
+  if (right->height > left->height + 1) {
+    return JoinLeft(left, right);
+  }
+  if (left->left == nullptr && right->left == nullptr &&
+      left->size + right->size <= kRopeLeafSize) {
+    String text = left->text + right->text;
+    return MakeLeaf(text);
+  }
+  return MakeNode(left, right);
+}
+
+// left заметно выше: спускаемся по правому краю left
+Rope::NodePtr Rope::JoinRight(const NodePtr& left, const NodePtr& right) {
+  const NodePtr& inner = left->right;
+  NodePtr joined = inner->height <= right->height + 1
+                       ? Join(inner, right)
+                       : JoinRight(inner, right);
+  if (joined->height <= left->left->height + 1) {
+    return MakeNode(left->left, joined);
+  }
+  // joined выше left->left на 2
+  if (Height(joined->left) > Height(joined->right)) {
+    joined = RotateRight(joined);
+  }
+  return RotateLeft(MakeNode(left->left, joined));
+}
+
+Rope::NodePtr Rope::JoinLeft(const NodePtr& left, const NodePtr& right) {
+  const NodePtr& inner = right->left;
+  NodePtr joined = inner->height <= left->height + 1
+                       ? Join(left, inner)
+                       : JoinLeft(left, inner);
+  if (joined->height <= right->right->height + 1) {
+    return MakeNode(joined, right->right);
+  }
+  if (Height(joined->right) > Height(joined->left)) {
+    joined = RotateLeft(joined);
+  }
+  return RotateRight(MakeNode(joined, right->right));
+}
+
+void Rope::Split(const NodePtr& node, size_t pos, NodePtr& left,
+                 NodePtr& right) {
+  if (node == nullptr || pos == 0) {
+    left = nullptr;
+    right = node;
+    return;
+  }
+  if (pos >= node->size) {
+    left = node;
+    right = nullptr;
+    return;
+  }
+  if (node->left == nullptr) {
+    const StringView kText = node->text;
+    left = MakeLeaf(kText.Substr(0, pos));
+    right = MakeLeaf(kText.Substr(pos));
+    return;
+  }
+  NodePtr part;
+  if (pos < node->left->size) {
+    Split(node->left, pos, left, part);
+    right = Join(part, node->right);
+  } else {
+    Split(node->right, pos - node->left->size, part, right);
+    left = Join(node->left, part);
+  }
+}
@@ -0,0 +1,222 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <new>
+
+#include "string.hpp"
+
+// строка с общим буфером (copy-on-write): копии делят один блок со
+// счётчиком ссылок, и копирование стоит одного атомарного инкремента.
+// Изменение сначала отделяет собственную копию, если блок ещё у кого-то
+// есть. Подходит для больших неизменяемых данных, которые раздаются
+// многим потребителям; обычный String всегда копирует буфер.
+// После выдачи изменяемой ссылки (operator[], MutableData) блок больше
+// не разделяется: запись через неё не должна менять копии, поэтому
+// следующие копии копируют байты, пока блок не будет заменён новым
+class SharedString {
+ public:
+  // конструкторы
+  SharedString() = default;
+  explicit SharedString(StringView str);
+
+  // правило пяти
+  SharedString(const SharedString& other);
+  SharedString& operator=(const SharedString& other);
+  SharedString(SharedString&& other) noexcept;
+  SharedString& operator=(SharedString&& other) noexcept;
+  ~SharedString();
+
+  // чтение, буфер не отделяется
+  bool Empty() const { return Size() == 0; }
+  size_t Size() const { return block_ == nullptr ? 0 : block_->size; }
+  const char* Data() const { return block_ == nullptr ? "" : Chars(); }
+  char operator[](size_t k_index) const { return Data()[k_index]; }
+  operator StringView() const { return StringView(Data(), Size()); }
+  String ToString() const { return String(StringView(*this)); }
+  // сколько SharedString делят буфер; 0 у пустой строки без буфера
+  size_t UseCount() const;
+
+  // изменение, буфер отделяется
+  char& operator[](size_t k_index);
+  char* MutableData();
+  void Clear();
+  void PushBack(char character);
+  void PopBack();
+  void Resize(size_t new_size, char character = '\0');
+  SharedString& operator+=(StringView str);
+
+ private:
+  // заголовок блока, символы и '\0' лежат сразу за ним
+  struct Block {
+    std::atomic<size_t> refs;
+    size_t size;
+    size_t capacity;
+    bool shareable;  // false, если наружу отдана изменяемая ссылка
+  };
+
+  static Block* Allocate(size_t capacity);
+  char* Chars() const { return reinterpret_cast<char*>(block_ + 1); }
+  void Release();
+  // свой блок вместимостью не меньше min_cap с прежним содержимым
+  void Detach(size_t min_cap);
+
+  Block* block_ = nullptr;
+};
+
+#include "shared_string.hpp"
+
+// конструкторы
+SharedString::SharedString(StringView str) {
+  if (str.Empty()) {
+    return;
+  }
+  block_ = Allocate(str.Size());
+  block_->size = str.Size();
+  memcpy(Chars(), str.Data(), str.Size());
+  Chars()[str.Size()] = '\0';
+}
+
+// правило пяти
+SharedString::SharedString(const SharedString& other) {
+  if (other.block_ != nullptr && !other.block_->shareable) {
+    *this = SharedString(StringView(other));
+    return;
+  }
+  block_ = other.block_;
+  if (block_ != nullptr) {
+    block_->refs.fetch_add(1, std::memory_order_relaxed);
+  }
+}
+
+SharedString& SharedString::operator=(const SharedString& other) {
+  if (block_ == other.block_) {
+    return *this;
+  }
+  SharedString copy(other);
+  std::swap(block_, copy.block_);
+  return *this;
+}
+
+SharedString::SharedString(SharedString&& other) noexcept
+    : block_(other.block_) {
+  other.block_ = nullptr;
+}
+
+SharedString& SharedString::operator=(SharedString&& other) noexcept {
+  if (this == &other) {
+    return *this;
+  }
+  Release();
+  block_ = other.block_;
+  other.block_ = nullptr;
+  return *this;
+}
+
+SharedString::~SharedString() { Release(); }
+
+size_t SharedString::UseCount() const {
+  return block_ == nullptr ? 0 : block_->refs.load(std::memory_order_acquire);
+}
+
+// изменение
+char& SharedString::operator[](size_t k_index) {
+  return MutableData()[k_index];
+}
+
+char* SharedString::MutableData() {
+  if (block_ == nullptr) {
+    block_ = Allocate(0);
+    Chars()[0] = '\0';
+  } else {
+    Detach(Size());
+  }
+  block_->shareable = false;
+  return Chars();
+}
+
+void SharedString::Clear() {
+  if (UseCount() > 1) {
+    Release();
+    return;
+  }
+  Resize(0);
+}
+
+void SharedString::PushBack(char character) {
+  *this += StringView(&character, 1);
+}
+
+void SharedString::PopBack() {
+  if (Empty()) {
+    return;
+  }
+  Resize(Size() - 1);
+}
+
+void SharedString::Resize(size_t new_size, char character) {
+  if (new_size == Size()) {
+    return;
+  }
+  const size_t kOldSize = Size();
+  Detach(new_size);
+  if (new_size > kOldSize) {
+    memset(Chars() + kOldSize, character, new_size - kOldSize);
+  }
+  block_->size = new_size;
+  Chars()[new_size] = '\0';
+}
+
+// str может смотреть в наш же буфер: новый блок заполняется до того,
+// как старый освобождается
+SharedString& SharedString::operator+=(StringView str) {
+  const size_t kOldSize = Size();
+  const size_t kNewSize = kOldSize + str.Size();
+  if (str.Empty()) {
+    return *this;
+  }
+  if (UseCount() == 1 && block_->capacity >= kNewSize) {
+    memcpy(Chars() + kOldSize, str.Data(), str.Size());
+  } else {
+    Block* block = Allocate(std::max(kNewSize, 2 * kOldSize));
+    char* chars = reinterpret_cast<char*>(block + 1);
+    memcpy(chars, Data(), kOldSize);
+    memcpy(chars + kOldSize, str.Data(), str.Size());
+    Release();
+    block_ = block;
+  }
+  block_->size = kNewSize;
+  Chars()[kNewSize] = '\0';
+  return *this;
+}
+
+// вспомогательные методы
+SharedString::Block* SharedString::Allocate(size_t capacity) {
+  void* memory = ::operator new(sizeof(Block) + capacity + 1);
+  return new (memory) Block{{1}, 0, capacity, true};
+}
+
+void SharedString::Release() {
+  if (block_ == nullptr) {
+    return;
+  }
+  // последний владелец должен видеть все записи остальных
+  if (block_->refs.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+    block_->~Block();
+    ::operator delete(block_);
+  }
+  block_ = nullptr;
+}
+
+void SharedString::Detach(size_t min_cap) {
+  if (block_ != nullptr && UseCount() == 1 && block_->capacity >= min_cap) {
+    return;
+  }
+  const size_t kSize = std::min(Size(), min_cap);
+  Block* block = Allocate(min_cap);
+  char* chars = reinterpret_cast<char*>(block + 1);
+  memcpy(chars, Data(), kSize);
+  chars[kSize] = '\0';
+  block->size = kSize;
+  Release();
+  block_ = block;
+}
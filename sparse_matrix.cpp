@@ -0,0 +1,351 @@
+#pragma once
+
+#include <algorithm>
+#include <stdexcept>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "matrix.cpp"
+
+// CSR - сжатые строки, CSC - сжатые столбцы
+enum class SparseFormat { kCsr, kCsc };
+
+// при меньшем числе ненулевых элементов потоки не окупаются
+const size_t kSparseParallelThreshold = 1 << 15;
+
+// вызывает func(begin, end) на непересекающихся отрезках [0, count),
+// распределяя их по аппаратным потокам
+template <typename Func>
+void ParallelForRanges(size_t count, size_t work, Func func) {
+  size_t threads = std::thread::hardware_concurrency();
+  if (work < kSparseParallelThreshold || threads <= 1 || count < 2) {
+    func(0, count);
+    return;
+  }
+  threads = std::min(threads, count);
+  const size_t kStep = (count + threads - 1) / threads;
+  std::vector<std::thread> pool;
+  for (size_t begin = kStep; begin < count; begin += kStep) {
+    pool.emplace_back(func, begin, std::min(count, begin + kStep));
+  }
+  func(0, kStep);
+  for (auto& thread : pool) {
+    thread.join();
+  }
+}
+
+// ненулевой элемент для сборки SparseMatrix без плотной матрицы
+template <typename T>
+struct SparseEntry {
+  size_t row;
+  size_t col;
+  T value;
+};
+
+template <size_t N, size_t M, typename T = int64_t>
+class SparseMatrix {
+ public:
+  SparseMatrix(SparseFormat format = SparseFormat::kCsr);
+  SparseMatrix(const Matrix<N, M, T>& mtx,
+               SparseFormat format = SparseFormat::kCsr);
+  // тройки в любом порядке; повторы одной позиции складываются, нули
+  // отбрасываются
+  SparseMatrix(const std::vector<SparseEntry<T>>& entries,
+               SparseFormat format = SparseFormat::kCsr);
+  // готовые массивы формата format, проверяются на корректность
+  SparseMatrix(SparseFormat format, std::vector<size_t> offsets,
+               std::vector<size_t> indices, std::vector<T> values);
+
+  // преобразования
+  Matrix<N, M, T> ToDense() const;
+  SparseMatrix<N, M, T> ToFormat(SparseFormat format) const;
+  // CSR матрицы - это CSC транспонированной с теми же массивами: они
+  // копируются, а у временной матрицы переносятся без копирования
+  SparseMatrix<M, N, T> Transposed() const&;
+  SparseMatrix<M, N, T> Transposed() &&;
+
+  // доступ
+  SparseFormat Format() const { return format_; }
+  size_t NonZeros() const { return values_.size(); }
+  T operator()(size_t k_index1, size_t k_index2) const;
+
+  // арифметика
+  SparseMatrix operator+(const SparseMatrix<N, M, T>& other) const;
+  std::vector<T> operator*(const std::vector<T>& vec) const;
+  template <size_t U>
+  Matrix<N, U, T> operator*(const Matrix<M, U, T>& mtx) const;
+
+ private:
+  template <size_t, size_t, typename>
+  friend class SparseMatrix;
+
+  size_t Outer() const { return format_ == SparseFormat::kCsr ? N : M; }
+  size_t Inner() const { return format_ == SparseFormat::kCsr ? M : N; }
+
+  SparseFormat format_;
+  std::vector<size_t> offsets_;  // начала строк (столбцов), Outer() + 1
+  std::vector<size_t> indices_;  // номера столбцов (строк) по возрастанию
+  std::vector<T> values_;
+};
+
+template <size_t N, size_t M, typename T>
+SparseMatrix<N, M, T>::SparseMatrix(SparseFormat format)
+    : format_(format), offsets_(Outer() + 1, 0) {}
+
+template <size_t N, size_t M, typename T>
+SparseMatrix<N, M, T>::SparseMatrix(const Matrix<N, M, T>& mtx,
+                                    SparseFormat format)
+    : SparseMatrix(format) {
+  const bool kCsr = (format_ == SparseFormat::kCsr);
+  for (size_t out = 0; out < Outer(); ++out) {
+    for (size_t in = 0; in < Inner(); ++in) {
+      const T kElem = kCsr ? mtx(out, in) : mtx(in, out);
+      if (kElem != T()) {
+        indices_.push_back(in);
+        values_.push_back(kElem);
+      }
+    }
+    offsets_[out + 1] = values_.size();
+  }
+}
+
+template <size_t N, size_t M, typename T>
+SparseMatrix<N, M, T>::SparseMatrix(
+    const std::vector<SparseEntry<T>>& entries, SparseFormat format)
+    : SparseMatrix(format) {
+  const bool kCsr = (format_ == SparseFormat::kCsr);
+  // раскладка подсчётом по внешнему индексу
+  std::vector<size_t> starts(Outer() + 1, 0);
+  for (const auto& entry : entries) {
+    if (entry.row >= N || entry.col >= M) {
+      throw std::invalid_argument("sparse entry out of range");
+    }
+    ++starts[(kCsr ? entry.row : entry.col) + 1];
+  }
+  for (size_t out = 0; out < Outer(); ++out) {
+    starts[out + 1] += starts[out];
+  }
+  std::vector<std::pair<size_t, T>> sorted(entries.size());
+  std::vector<size_t> fill(starts.begin(), starts.end() - 1);
+  for (const auto& entry : entries) {
+    const size_t kOut = kCsr ? entry.row : entry.col;
+    sorted[fill[kOut]++] = {kCsr ? entry.col : entry.row, entry.value};
+  }
+  indices_.reserve(entries.size());
+  values_.reserve(entries.size());
+  for (size_t out = 0; out < Outer(); ++out) {
+    auto begin = sorted.begin() + starts[out];
+    auto end = sorted.begin() + starts[out + 1];
+    std::stable_sort(begin, end, [](const auto& lhs, const auto& rhs) {
+      return lhs.first < rhs.first;
+    });
+    while (begin != end) {
+      const size_t kIn = begin->first;
+      T sum = T();
+      for (; begin != end && begin->first == kIn; ++begin) {
+        sum += begin->second;
+      }
+      if (sum != T()) {
+        indices_.push_back(kIn);
+        values_.push_back(sum);
+      }
+    }
+    offsets_[out + 1] = values_.size();
+  }
+}
+
+template <size_t N, size_t M, typename T>
+SparseMatrix<N, M, T>::SparseMatrix(SparseFormat format,
+                                    std::vector<size_t> offsets,
+                                    std::vector<size_t> indices,
+                                    std::vector<T> values)
+    : format_(format),
+      offsets_(std::move(offsets)),
+      indices_(std::move(indices)),
+      values_(std::move(values)) {
+  if (offsets_.size() != Outer() + 1 || offsets_[0] != 0 ||
+      offsets_.back() != indices_.size() ||
+      indices_.size() != values_.size()) {
+    throw std::invalid_argument("sparse matrix size mismatch");
+  }
+  for (size_t out = 0; out < Outer(); ++out) {
+    if (offsets_[out] > offsets_[out + 1]) {
+      throw std::invalid_argument("sparse offsets are not sorted");
+    }
+    for (size_t pos = offsets_[out]; pos < offsets_[out + 1]; ++pos) {
+      if (indices_[pos] >= Inner() ||
+          (pos > offsets_[out] && indices_[pos - 1] >= indices_[pos])) {
+        throw std::invalid_argument("sparse indices are not sorted");
+      }
+    }
+  }
+}
+
+template <size_t N, size_t M, typename T>
+Matrix<N, M, T> SparseMatrix<N, M, T>::ToDense() const {
+  Matrix<N, M, T> result;
+  const bool kCsr = (format_ == SparseFormat::kCsr);
+  for (size_t out = 0; out < Outer(); ++out) {
+    for (size_t pos = offsets_[out]; pos < offsets_[out + 1]; ++pos) {
+      if (kCsr) {
+        result(out, indices_[pos]) = values_[pos];
+      } else {
+        result(indices_[pos], out) = values_[pos];
+      }
+    }
+  }
+  return result;
+}
+
+template <size_t N, size_t M, typename T>
+SparseMatrix<N, M, T> SparseMatrix<N, M, T>::ToFormat(
+    SparseFormat format) const {
+  if (format == format_) {
+    return *this;
+  }
+  // сортировка подсчётом по внутреннему индексу
+  SparseMatrix<N, M, T> result(format);
+  result.indices_.resize(NonZeros());
+  result.values_.resize(NonZeros());
+  for (size_t idx : indices_) {
+    ++result.offsets_[idx + 1];
+  }
+  for (size_t i = 0; i < result.Outer(); ++i) {
+    result.offsets_[i + 1] += result.offsets_[i];
+  }
+  std::vector<size_t> fill(result.offsets_.begin(), result.offsets_.end() - 1);
+  for (size_t out = 0; out < Outer(); ++out) {
+    for (size_t pos = offsets_[out]; pos < offsets_[out + 1]; ++pos) {
+      const size_t kDst = fill[indices_[pos]]++;
+      result.indices_[kDst] = out;
+      result.values_[kDst] = values_[pos];
+    }
+  }
+  return result;
+}
+
+template <size_t N, size_t M, typename T>
+SparseMatrix<M, N, T> SparseMatrix<N, M, T>::Transposed() const& {
+  return SparseMatrix(*this).Transposed();
+}
+
+template <size_t N, size_t M, typename T>
+SparseMatrix<M, N, T> SparseMatrix<N, M, T>::Transposed() && {
+  SparseMatrix<M, N, T> result(format_ == SparseFormat::kCsr
+                                   ? SparseFormat::kCsc
+                                   : SparseFormat::kCsr);
+  result.offsets_ = std::move(offsets_);
+  result.indices_ = std::move(indices_);
+  result.values_ = std::move(values_);
+  offsets_.assign(Outer() + 1, 0);
+  indices_.clear();
+  values_.clear();
+  return result;
+}
+
+template <size_t N, size_t M, typename T>
+T SparseMatrix<N, M, T>::operator()(size_t k_index1, size_t k_index2) const {
+  const size_t kOut = (format_ == SparseFormat::kCsr) ? k_index1 : k_index2;
+  const size_t kIn = (format_ == SparseFormat::kCsr) ? k_index2 : k_index1;
+  auto begin = indices_.begin() + offsets_[kOut];
+  auto end = indices_.begin() + offsets_[kOut + 1];
+  auto iter = std::lower_bound(begin, end, kIn);
+  if (iter == end || *iter != kIn) {
+    return T();
+  }
+  return values_[iter - indices_.begin()];
+}
+
+template <size_t N, size_t M, typename T>
+SparseMatrix<N, M, T> SparseMatrix<N, M, T>::operator+(
+    const SparseMatrix<N, M, T>& other) const {
+  if (other.format_ != format_) {
+    return *this + other.ToFormat(format_);
+  }
+  SparseMatrix<N, M, T> result(format_);
+  result.indices_.reserve(NonZeros() + other.NonZeros());
+  result.values_.reserve(NonZeros() + other.NonZeros());
+  for (size_t out = 0; out < Outer(); ++out) {
+    size_t lhs = offsets_[out];
+    size_t rhs = other.offsets_[out];
+    while (lhs < offsets_[out + 1] || rhs < other.offsets_[out + 1]) {
+      size_t idx;
+      T sum;
+      if (rhs == other.offsets_[out + 1] ||
+          (lhs < offsets_[out + 1] && indices_[lhs] < other.indices_[rhs])) {
+        idx = indices_[lhs];
+        sum = values_[lhs++];
+      } else if (lhs == offsets_[out + 1] ||
+                 other.indices_[rhs] < indices_[lhs]) {
+        idx = other.indices_[rhs];
+        sum = other.values_[rhs++];
+      } else {
+        idx = indices_[lhs];
+        sum = values_[lhs++] + other.values_[rhs++];
+      }
+      if (sum != T()) {
+        result.indices_.push_back(idx);
+        result.values_.push_back(sum);
+      }
+    }
+    result.offsets_[out + 1] = result.values_.size();
+  }
+  return result;
+}
+
+template <size_t N, size_t M, typename T>
+std::vector<T> SparseMatrix<N, M, T>::operator*(
+    const std::vector<T>& vec) const {
+  if (vec.size() != M) {
+    throw std::invalid_argument("matrix size mismatch");
+  }
+  std::vector<T> result(N, T());
+  if (format_ == SparseFormat::kCsc) {
+    for (size_t col = 0; col < M; ++col) {
+      for (size_t pos = offsets_[col]; pos < offsets_[col + 1]; ++pos) {
+        result[indices_[pos]] += values_[pos] * vec[col];
+      }
+    }
+    return result;
+  }
+  ParallelForRanges(N, NonZeros(), [&](size_t begin, size_t end) {
+    for (size_t row = begin; row < end; ++row) {
+      T sum = T();
+      for (size_t pos = offsets_[row]; pos < offsets_[row + 1]; ++pos) {
+        sum += values_[pos] * vec[indices_[pos]];
+      }
+      result[row] = sum;
+    }
+  });
+  return result;
+}
+
+template <size_t N, size_t M, typename T>
+template <size_t U>
+Matrix<N, U, T> SparseMatrix<N, M, T>::operator*(
+    const Matrix<M, U, T>& mtx) const {
+  Matrix<N, U, T> result;
+  T* dst = result.Data();
+  const T* src = mtx.Data();
+  if (format_ == SparseFormat::kCsc) {
+    for (size_t col = 0; col < M; ++col) {
+      for (size_t pos = offsets_[col]; pos < offsets_[col + 1]; ++pos) {
+        for (size_t j = 0; j < U; ++j) {
+          dst[indices_[pos] * U + j] += values_[pos] * src[col * U + j];
+        }
+      }
+    }
+    return result;
+  }
+  ParallelForRanges(N, NonZeros() * U, [&](size_t begin, size_t end) {
+    for (size_t row = begin; row < end; ++row) {
+      for (size_t pos = offsets_[row]; pos < offsets_[row + 1]; ++pos) {
+        for (size_t j = 0; j < U; ++j) {
+          dst[row * U + j] += values_[pos] * src[indices_[pos] * U + j];
+        }
+      }
+    }
+  });
+  return result;
+}
@@ -1,20 +1,132 @@
 #pragma once
 #include <string.h>
 
+#include <algorithm>
+#include <charconv>
+#include <cstdint>
+#include <functional>
 #include <iostream>
+#include <limits>
+#include <memory_resource>
+#include <type_traits>
 #include <vector>
 
+#if __has_include(<compare>)
+#include <compare>
+#endif
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+const size_t kNpos = SIZE_MAX;  // "не найдено" для методов поиска
+const size_t kLongNeedleSize = 32;  // с этой длины поиск идёт по Хорспулу
+
 size_t GetRealCap(size_t size);  // для подбора вместимости
+// первое вхождение needle в haystack или nullptr; нули внутри допустимы.
+// Короткие needle ищутся SIMD-фильтром по первому и последнему байту,
+// длинные - алгоритмом Хорспула
+const char* FindBytes(const char* haystack, size_t haystack_size,
+                      const char* needle, size_t needle_size);
+// последнее вхождение: тот же SIMD-фильтр, блоки идут от конца
+const char* RFindBytes(const char* haystack, size_t haystack_size,
+                       const char* needle, size_t needle_size);
+// хеш в духе wyhash: блоки по 48 байт в три независимые цепочки
+// умножений 64x64->128, короткие строки читаются парой перекрывающихся слов
+uint64_t HashBytes(const char* data, size_t size, uint64_t seed = 0);
+
+// невладеющий взгляд на чужие байты; '\0' в конце не гарантируется,
+// нули внутри допустимы
+class StringView {
+ public:
+  StringView() = default;
+  StringView(const char* str) : data_(str), size_(strlen(str)) {}
+  StringView(const char* data, size_t size) : data_(data), size_(size) {}
+
+  bool Empty() const { return size_ == 0; }
+  size_t Size() const { return size_; }
+  const char* Data() const { return data_; }
+  const char* begin() const { return data_; }
+  const char* end() const { return data_ + size_; }
+
+  char operator[](size_t k_index) const { return data_[k_index]; }
+  char Front() const { return data_[0]; }
+  char Back() const { return data_[size_ - 1]; }
+
+  // count обрезается по концу строки
+  StringView Substr(size_t pos, size_t count = SIZE_MAX) const {
+    return StringView(data_ + pos, std::min(count, size_ - pos));
+  }
+  void RemovePrefix(size_t count) {
+    data_ += count;
+    size_ -= count;
+  }
+  void RemoveSuffix(size_t count) { size_ -= count; }
+
+  // поиск; возвращают kNpos, если ничего не найдено
+  size_t Find(StringView needle, size_t pos = 0) const;
+  size_t RFind(StringView needle, size_t pos = kNpos) const;
+  size_t FindFirstOf(StringView chars, size_t pos = 0) const;
+  bool Contains(StringView needle) const { return Find(needle) != kNpos; }
+  size_t Count(StringView needle) const;  // непересекающиеся вхождения
+
+  // числа через from_chars, без локали: весь взгляд должен быть числом
+  // (без пробелов и '+'), иначе false и value не меняется
+  template <typename Int>
+  bool ParseInt(Int& value, int base = 10) const {
+    Int result;
+    const auto [end, error] =
+        std::from_chars(data_, data_ + size_, result, base);
+    if (error != std::errc() || end != data_ + size_) {
+      return false;
+    }
+    value = result;
+    return true;
+  }
+  bool ParseDouble(double& value) const;
+
+ private:
+  const char* data_ = "";
+  size_t size_ = 0;
+};
+
+// ленивый разбор по разделителю: токены - взгляды в исходный буфер,
+// память не выделяется. Пустые токены сохраняются, как в Split
+class Tokenizer {
+ public:
+  Tokenizer(StringView text, StringView delim = " ")
+      : rest_(text), delim_(delim) {}
+
+  // false, когда токены закончились
+  bool Next(StringView& token);
+
+ private:
+  StringView rest_;
+  StringView delim_;
+  bool done_ = false;
+};
+
 class String {
  public:
   // конструкторы
   String();
   String(size_t size, char character);
   String(const char* str);
+  explicit String(StringView str);
+  // буферы берутся из resource, например из std::pmr::monotonic_buffer_
+  // resource, и освобождаются всем арендным блоком сразу. nullptr - куча
+  explicit String(std::pmr::memory_resource* resource);
+  String(StringView str, std::pmr::memory_resource* resource);
 
-  // правило трёх
+  // правило пяти. Копия берёт буфер из кучи, копирующее присваивание
+  // оставляет свой ресурс; перемещение и Swap передают ресурс вместе
+  // с буфером, поэтому не выделяют память и не бросают исключений
   String(const String& str);
   String& operator=(const String& str);
+  String(String&& str) noexcept;
+  String& operator=(String&& str) noexcept;
   ~String();
 
   // дефолтные методы
@@ -36,30 +148,16 @@ class String {
   size_t Capacity() const;
   char* Data();
   const char* Data() const;
+  std::pmr::memory_resource* Resource() const { return resource_; }
+  operator StringView() const;
 
   // операторы сложения и умножения
-  String& operator+=(const String& str);
-  String operator+(const String& other) const;
+  String& operator+=(StringView str);
+  String operator+(StringView other) const&;
+  String operator+(StringView other) &&;  // дописывает в свой буфер
   String operator*(size_t k_n) const;
   String& operator*=(size_t k_n);
 
-  // булевые операторы
-  /* некостантные */
-  bool operator<(const String& str_2);
-  bool operator<=(const String& str_2);
-  bool operator>(const String& str_2);
-  bool operator>=(const String& str_2);
-  bool operator==(const String& str_2);
-  bool operator!=(const String& str_2);
-
-  /* константные */
-  bool operator<(const String& str_2) const;
-  bool operator<=(const String& str_2) const;
-  bool operator>(const String& str_2) const;
-  bool operator>=(const String& str_2) const;
-  bool operator==(const String& str_2) const;
-  bool operator!=(const String& str_2) const;
-
   // операторы и методы доступа
   /* неконстантные */
   char& operator[](size_t k_index);
@@ -70,95 +168,314 @@ class String {
   /* константные */
   char operator[](size_t k_index) const;
 
-  std::vector<String> Split(const String& delim = " ");
+  // поиск, см. одноимённые методы StringView
+  size_t Find(StringView needle, size_t pos = 0) const;
+  size_t RFind(StringView needle, size_t pos = kNpos) const;
+  size_t FindFirstOf(StringView chars, size_t pos = 0) const;
+  bool Contains(StringView needle) const;
+  size_t Count(StringView needle) const;
+
+  // числа через to_chars/from_chars, без локали и потоков. FromDouble и
+  // AppendDouble пишут кратчайшую запись, читающуюся в то же значение
+  template <typename Int>
+  static String FromInt(Int value) {
+    String result;
+    result.AppendInt(value);
+    return result;
+  }
+  static String FromDouble(double value);
+  template <typename Int>
+  String& AppendInt(Int value) {
+    static_assert(std::is_integral_v<Int>, "AppendInt needs an integer");
+    // цифры, знак и возможный лишний разряд сверх digits10
+    Grow(size_ + std::numeric_limits<Int>::digits10 + 2);
+    size_ = std::to_chars(string_ + size_, string_ + Capacity(), value).ptr -
+            string_;
+    string_[size_] = '\0';
+    return *this;
+  }
+  String& AppendDouble(double value);
+  template <typename Int>
+  bool ParseInt(Int& value, int base = 10) const {
+    return StringView(*this).ParseInt(value, base);
+  }
+  bool ParseDouble(double& value) const;
+
+  std::vector<String> Split(StringView delim = " ") const;
+  std::vector<StringView> SplitView(StringView delim = " ") const;
   String Join(const std::vector<String>& strings) const;
+  String Join(const std::vector<StringView>& strings) const;
 
  private:
-  char* string_;
+  // строки до kLocalCapacity символов хранятся прямо в объекте (SSO)
+  static constexpr size_t kLocalCapacity = 23;
+
+  char* string_;  // local_ для коротких строк, иначе буфер в куче
   size_t size_;
-  size_t capacity_;
-  void Refill(size_t n_size) {
-    String tmp = *this;
-    delete[] string_;
-    size_ = n_size;
-    capacity_ = GetRealCap(size_);
-    string_ = new char[capacity_ + 1];
-    memcpy(string_, tmp.string_, tmp.size_);
+  union {
+    size_t capacity_;  // только для буфера в куче
+    char local_[kLocalCapacity + 1];
+  };
+  std::pmr::memory_resource* resource_ = nullptr;
+
+  bool IsLocal() const { return string_ == local_; }
+  char* NewBuffer(size_t cap) const {
+    if (resource_ == nullptr) {
+      return new char[cap + 1];
+    }
+    return static_cast<char*>(resource_->allocate(cap + 1, 1));
+  }
+  void DeleteBuffer(char* buffer, size_t cap) const {
+    if (resource_ == nullptr) {
+      delete[] buffer;
+    } else {
+      resource_->deallocate(buffer, cap + 1, 1);
+    }
+  }
+  // буфер под new_cap символов и '\0'; старое содержимое не сохраняется
+  void Allocate(size_t new_cap) {
+    if (new_cap <= kLocalCapacity) {
+      string_ = local_;
+      return;
+    }
+    string_ = NewBuffer(new_cap);
+    capacity_ = new_cap;
+  }
+  void Deallocate() {
+    if (!IsLocal()) {
+      DeleteBuffer(string_, capacity_);
+    }
+  }
+  // переезд в буфер под new_cap >= size_ символов с сохранением содержимого
+  void Reallocate(size_t new_cap) {
+    if (new_cap <= kLocalCapacity && IsLocal()) {
+      return;
+    }
+    char* old_string = string_;
+    bool was_local = IsLocal();
+    const size_t kOldCap = Capacity();
+    if (new_cap <= kLocalCapacity) {
+      string_ = local_;
+    } else {
+      string_ = NewBuffer(new_cap);
+    }
+    memcpy(string_, old_string, size_ + 1);
+    if (!was_local) {
+      DeleteBuffer(old_string, kOldCap);
+    }
+    if (!IsLocal()) {
+      capacity_ = new_cap;
+    }
+  }
+  // забирает буфер str, оставляя её пустой; свой буфер уже освобождён
+  void Steal(String& str) noexcept {
+    size_ = str.size_;
+    if (str.IsLocal()) {
+      string_ = local_;
+      memcpy(local_, str.local_, size_ + 1);
+    } else {
+      string_ = str.string_;
+      capacity_ = str.capacity_;
+    }
+    str.string_ = str.local_;
+    str.size_ = 0;
+    str.local_[0] = '\0';
+  }
+  // геометрический рост: realloc только при нехватке места
+  void Grow(size_t min_cap) {
+    if (min_cap > Capacity()) {
+      Reallocate(std::max(min_cap, 2 * Capacity()));
+    }
   }
 };
 
+// собирает строку из кусков: размер считается один раз, результат
+// заполняется в одно выделение памяти
+class StringBuilder {
+ public:
+  // кусок не копируется и должен жить до Build
+  StringBuilder& Append(StringView piece);
+  // кусок копируется во внутренний буфер, годится для временных строк
+  StringBuilder& AppendCopy(StringView piece);
+  StringBuilder& Append(char character);
+  StringBuilder& operator<<(StringView piece) { return Append(piece); }
+
+  size_t Size() const { return size_; }
+  String Build(std::pmr::memory_resource* resource = nullptr) const;
+  void Clear();
+
+ private:
+  // data == nullptr - кусок лежит в owned_ со смещения offset
+  struct Piece {
+    const char* data;
+    size_t offset;
+    size_t size;
+  };
+
+  std::vector<Piece> pieces_;
+  String owned_;
+  size_t size_ = 0;
+};
+
+// лексикографическое сравнение байтов как unsigned char: <0, 0 или >0
+int Compare(StringView str_1, StringView str_2);
 int Strcmp(const String& str_1, const String& str_2);
 
+// булевые операторы
+bool operator<(StringView str_1, StringView str_2);
+bool operator<=(StringView str_1, StringView str_2);
+bool operator>(StringView str_1, StringView str_2);
+bool operator>=(StringView str_1, StringView str_2);
+bool operator==(StringView str_1, StringView str_2);
+bool operator!=(StringView str_1, StringView str_2);
+#if defined(__cpp_lib_three_way_comparison)
+std::strong_ordering operator<=>(StringView str_1, StringView str_2);
+#endif
+
+// строка-ключ с хешем, посчитанным один раз при создании: поиск в хеш-
+// таблицах не перехеширует неизменяемые ключи, а равенство сначала
+// сверяет хеши. Менять можно только присваиванием, оно пересчитывает хеш
+class HashedString {
+ public:
+  HashedString() : hash_(HashBytes("", 0)) {}
+  explicit HashedString(StringView str)
+      : str_(str), hash_(HashBytes(str.Data(), str.Size())) {}
+  explicit HashedString(String&& str)
+      : str_(std::move(str)), hash_(HashBytes(str_.Data(), str_.Size())) {}
+
+  HashedString& operator=(StringView str) { return *this = HashedString(str); }
+
+  const String& Str() const { return str_; }
+  size_t Size() const { return str_.Size(); }
+  uint64_t Hash() const { return hash_; }
+  operator StringView() const { return str_; }
+
+ private:
+  String str_;
+  uint64_t hash_;
+};
+
+bool operator==(const HashedString& str_1, const HashedString& str_2);
+bool operator!=(const HashedString& str_1, const HashedString& str_2);
+
+namespace std {
+template <>
+struct hash<StringView> {
+  size_t operator()(StringView str) const {
+    return HashBytes(str.Data(), str.Size());
+  }
+};
+
+template <>
+struct hash<String> {
+  size_t operator()(const String& str) const {
+    return HashBytes(str.Data(), str.Size());
+  }
+};
+
+template <>
+struct hash<HashedString> {
+  size_t operator()(const HashedString& str) const { return str.Hash(); }
+};
+}  // namespace std
+
 // операторы ввода и вывода
 std::ostream& operator<<(std::ostream& os_out, const String& str);
+std::ostream& operator<<(std::ostream& os_out, StringView str);
+// пропускает пробелы и читает слово; пробел после слова остаётся в потоке
 std::istream& operator>>(std::istream& input, String& str);
+// читает до delim, сам delim извлекается, но в str не попадает
+std::istream& GetLine(std::istream& input, String& str, char delim = '\n');
 
 #include "string.hpp"
 
 // конструкторы
-String::String() : string_(new char[1]) {
+String::String() : string_(local_) {
   string_[0] = '\0';
   size_ = 0;
-  capacity_ = 0;
 }
 
 String::String(size_t size, char character) {
   size_ = size;
-  capacity_ = GetRealCap(size_);
-  string_ = new char[capacity_ + 1];
+  Allocate(GetRealCap(size_));
   memset(string_, character, size_);
   string_[size_] = '\0';
 }
 
 String::String(const char* str) {
   size_ = strlen(str);
-  capacity_ = GetRealCap(size_);
-  string_ = new char[capacity_ + 1];
+  Allocate(GetRealCap(size_));
   for (size_t i = 0; i < size_; ++i) {
     string_[i] = str[i];
   }
   string_[size_] = '\0';
 }
 
-// правило трёх
+String::String(StringView str) : String(str, nullptr) {}
+
+String::String(std::pmr::memory_resource* resource)
+    : string_(local_), size_(0), resource_(resource) {
+  string_[0] = '\0';
+}
+
+String::String(StringView str, std::pmr::memory_resource* resource)
+    : size_(str.Size()), resource_(resource) {
+  Allocate(GetRealCap(size_));
+  memcpy(string_, str.Data(), size_);
+  string_[size_] = '\0';
+}
+
+// правило пяти
 String::String(const String& str) : String::String(str.size_, '\0') {
   memcpy(string_, str.string_, size_);
 }
 
-String::~String() { delete[] string_; }
+String::String(String&& str) noexcept : resource_(str.resource_) {
+  Steal(str);
+}
+
+String::~String() { Deallocate(); }
 
 String& String::operator=(const String& str) {
   if (this == &str) {
     return *this;
   }
-  delete[] string_;
-  string_ = new char[str.capacity_ + 1];
+  // новый буфер выделяется до освобождения старого: если ресурс бросит
+  // исключение, строка останется прежней
+  if (str.size_ > Capacity()) {
+    const size_t kNewCap = GetRealCap(str.size_);
+    char* buffer = NewBuffer(kNewCap);
+    Deallocate();
+    string_ = buffer;
+    capacity_ = kNewCap;
+  }
   size_ = str.size_;
-  capacity_ = str.capacity_;
   memcpy(string_, str.string_, size_);
   string_[size_] = '\0';
   return *this;
 }
 
+String& String::operator=(String&& str) noexcept {
+  if (this == &str) {
+    return *this;
+  }
+  Deallocate();
+  resource_ = str.resource_;
+  Steal(str);
+  return *this;
+}
+
 // дефолтные методы
+// буфер сохраняется для повторного заполнения
 void String::Clear() {
-  delete[] string_;
   size_ = 0;
-  capacity_ = 0;
-  string_ = new char[capacity_ + 1];
   string_[size_] = '\0';
 }
 
 void String::PushBack(char character) {
-  String tmp = *this;
-  delete[] string_;
+  Grow(size_ + 1);
+  string_[size_] = character;
   ++size_;
-  capacity_ = GetRealCap(size_);
-  string_ = new char[capacity_ + 1];
-  for (size_t i = 0; i < tmp.size_; ++i) {
-    string_[i] = tmp.string_[i];
-  }
-  string_[size_ - 1] = character;
   string_[size_] = '\0';
 }
 
@@ -166,183 +483,171 @@ void String::PopBack() {
   if (size_ == 0) {
     return;
   }
-  String tmp = *this;
-  delete[] string_;
   --size_;
-  capacity_ = GetRealCap(size_);
-  string_ = new char[capacity_ + 1];
-  for (size_t i = 0; i < size_; ++i) {
-    string_[i] = tmp.string_[i];
-  }
   string_[size_] = '\0';
 }
 
 // методы изменения размера
-void String::Resize(size_t new_size) {
-  if (new_size > capacity_) {
-    Refill(new_size);
-    string_[size_] = '\0';
-    size_ = new_size;
-    return;
-  }
-  size_ = new_size;
-  string_[size_] = '\0';
-}
+void String::Resize(size_t new_size) { Resize(new_size, '\0'); }
 
 void String::Resize(size_t new_size, char character) {
-  if (new_size > capacity_) {
-    String tmp = *this;
-    Refill(new_size);
-    for (size_t i = tmp.size_; i < size_; ++i) {
-      string_[i] = character;
-    }
-    string_[size_] = '\0';
-    return;
-  }
+  Grow(new_size);
   if (new_size > size_) {
-    for (size_t i = size_; i < new_size; ++i) {
-      string_[i] = character;
-    }
-    size_ = new_size;
-    string_[size_] = '\0';
-    return;
+    memset(string_ + size_, character, new_size - size_);
   }
-  String tmp = *this;
-  delete[] string_;
   size_ = new_size;
-  capacity_ = GetRealCap(size_);
-  string_ = new char[capacity_ + 1];
-  memcpy(string_, tmp.string_, size_);
   string_[size_] = '\0';
 }
 
 void String::Reserve(size_t new_cap) {
-  capacity_ = std::max(capacity_, new_cap);
+  if (new_cap > Capacity()) {
+    Reallocate(new_cap);
+  }
 }
 
 void String::ShrinkToFit() {
-  capacity_ = (capacity_ >= size_) ? size_ : capacity_;
+  if (Capacity() > size_) {
+    Reallocate(size_);
+  }
 }
 
 // свап строк
 void String::Swap(String& other) {
-  std::swap(string_, other.string_);
+  std::swap(resource_, other.resource_);
+  if (!IsLocal() && !other.IsLocal()) {
+    std::swap(string_, other.string_);
+    std::swap(capacity_, other.capacity_);
+  } else if (IsLocal() && other.IsLocal()) {
+    std::swap(local_, other.local_);
+  } else {
+    String& local = IsLocal() ? *this : other;
+    String& heap = IsLocal() ? other : *this;
+    char* buffer = heap.string_;
+    size_t capacity = heap.capacity_;
+    memcpy(heap.local_, local.local_, local.size_ + 1);
+    heap.string_ = heap.local_;
+    local.string_ = buffer;
+    local.capacity_ = capacity;
+  }
   std::swap(size_, other.size_);
-  std::swap(capacity_, other.capacity_);
 }
 
 // методы для доступа данных о строке
 bool String::Empty() const { return size_ == 0; }
 size_t String::Size() const { return size_; }
-size_t String::Capacity() const { return capacity_; }
+size_t String::Capacity() const {
+  return IsLocal() ? kLocalCapacity : capacity_;
+}
 char* String::Data() { return string_; }
 const char* String::Data() const { return string_; }
+String::operator StringView() const { return StringView(string_, size_); }
 
 // операторы сложения и умножения
-String& String::operator+=(const String& str) {
-  if (size_ + str.size_ <= capacity_) {
-    for (size_t i = 0; i < str.size_; ++i) {
-      string_[i + size_] = str.string_[i];
-    }
-    size_ += str.size_;
-    string_[size_] = '\0';
-    return *this;
-  }
-  String copy = *this;
-  delete[] string_;
-  size_ += str.size_;
-  capacity_ = GetRealCap(size_);
-  string_ = new char[capacity_ + 1];
-  for (size_t i = 0; i < copy.size_; ++i) {
-    string_[i] = copy.string_[i];
-  }
-  for (size_t i = 0; i < str.size_; ++i) {
-    string_[i + copy.size_] = str.string_[i];
+String& String::operator+=(StringView str) {
+  // str может смотреть в наш же буфер, который Grow освободит
+  const char* src = str.Data();
+  if (src >= string_ && src <= string_ + size_) {
+    const size_t kOffset = src - string_;
+    Grow(size_ + str.Size());
+    src = string_ + kOffset;
+  } else {
+    Grow(size_ + str.Size());
   }
+  memcpy(string_ + size_, src, str.Size());
+  size_ += str.Size();
   string_[size_] = '\0';
   return *this;
 }
 
-String String::operator+(const String& other) const {
-  String tmp = *this;
+String String::operator+(StringView other) const& {
+  String tmp(resource_);
+  tmp.Reserve(size_ + other.Size());
+  tmp += *this;
   tmp += other;
   return tmp;
 }
 
+String String::operator+(StringView other) && {
+  *this += other;
+  return std::move(*this);
+}
+
 String String::operator*(size_t k_n) const {
-  String result;
-  for (size_t i = 0; i < k_n; ++i) {
+  String result(resource_);
+  if (k_n != 0) {
+    result.Reserve(size_ * k_n);
     result += *this;
+    result *= k_n;
   }
   return result;
 }
 
+// удвоением: log(k_n) копирований уже готового префикса
 String& String::operator*=(size_t k_n) {
-  *this = *this * k_n;
-  return *this;
+  const size_t kTotal = size_ * k_n;
+  if (kTotal == 0) {
+    Clear();
+    return *this;
+  }
+  Reserve(kTotal);
+  while (2 * size_ <= kTotal) {
+    *this += StringView(*this);
+  }
+  return *this += StringView(string_, kTotal - size_);
 }
 
 // булевые операторы
-/* некостантные */
-bool String::operator<(const String& str_2) {
-  int res = Strcmp(string_, str_2.string_);
-  return res < 0;
+// свободные функции над StringView, поэтому String, StringView и const char*
+// сравниваются в любых сочетаниях без временных строк
+bool operator<(StringView str_1, StringView str_2) {
+  return Compare(str_1, str_2) < 0;
 }
 
-bool String::operator<=(const String& str_2) {
-  int res = Strcmp(string_, str_2.string_);
-  return res <= 0;
+bool operator<=(StringView str_1, StringView str_2) {
+  return Compare(str_1, str_2) <= 0;
 }
 
-bool String::operator>(const String& str_2) {
-  int res = Strcmp(string_, str_2.string_);
-  return res > 0;
+bool operator>(StringView str_1, StringView str_2) {
+  return Compare(str_1, str_2) > 0;
 }
 
-bool String::operator>=(const String& str_2) {
-  int res = Strcmp(string_, str_2.string_);
-  return res >= 0;
+bool operator>=(StringView str_1, StringView str_2) {
+  return Compare(str_1, str_2) >= 0;
 }
 
-bool String::operator==(const String& str_2) {
-  int res = Strcmp(string_, str_2.string_);
-  return res == 0;
-}
-
-bool String::operator!=(const String& str_2) {
-  int res = Strcmp(string_, str_2.string_);
-  return res != 0;
-}
-
-/* константные */
-bool String::operator<(const String& str_2) const {
-  int res = Strcmp(string_, str_2.string_);
-  return res < 0;
-}
-
-bool String::operator<=(const String& str_2) const {
-  int res = Strcmp(string_, str_2.string_);
-  return res <= 0;
+// сначала длины и первое машинное слово, memcmp только для похожих строк
+bool operator==(StringView str_1, StringView str_2) {
+  if (str_1.Size() != str_2.Size()) {
+    return false;
+  }
+  if (str_1.Size() >= sizeof(uint64_t)) {
+    uint64_t word_1;
+    uint64_t word_2;
+    memcpy(&word_1, str_1.Data(), sizeof(word_1));
+    memcpy(&word_2, str_2.Data(), sizeof(word_2));
+    if (word_1 != word_2) {
+      return false;
+    }
+  }
+  return memcmp(str_1.Data(), str_2.Data(), str_1.Size()) == 0;
 }
 
-bool String::operator>(const String& str_2) const {
-  int res = Strcmp(string_, str_2.string_);
-  return res > 0;
+bool operator!=(StringView str_1, StringView str_2) {
+  return !(str_1 == str_2);
 }
 
-bool String::operator>=(const String& str_2) const {
-  int res = Strcmp(string_, str_2.string_);
-  return res >= 0;
+#if defined(__cpp_lib_three_way_comparison)
+std::strong_ordering operator<=>(StringView str_1, StringView str_2) {
+  return Compare(str_1, str_2) <=> 0;
 }
+#endif
 
-bool String::operator==(const String& str_2) const {
-  int res = Strcmp(string_, str_2.string_);
-  return res == 0;
+bool operator==(const HashedString& str_1, const HashedString& str_2) {
+  return str_1.Hash() == str_2.Hash() && StringView(str_1) == str_2;
 }
 
-bool String::operator!=(const String& str_2) const {
-  int res = Strcmp(string_, str_2.string_);
-  return res != 0;
+bool operator!=(const HashedString& str_1, const HashedString& str_2) {
+  return !(str_1 == str_2);
 }
 
 // операторы и методы доступа
@@ -360,67 +665,302 @@ const char& String::Front() const { return string_[0]; }
 
 const char& String::Back() const { return string_[size_ - 1]; }
 
+// чтение из буфера потока
+// указатели буфера streambuf защищены, но указатель на защищённый метод,
+// взятый через наследника, применим к любому streambuf
+class StreamBufferAccess : public std::streambuf {
+ public:
+  static const char* Begin(std::streambuf* buf) {
+    return (buf->*&StreamBufferAccess::gptr)();
+  }
+  static const char* End(std::streambuf* buf) {
+    return (buf->*&StreamBufferAccess::egptr)();
+  }
+  static void Skip(std::streambuf* buf, size_t count) {
+    (buf->*&StreamBufferAccess::gbump)(static_cast<int>(count));
+  }
+};
+
+// дописывает в str содержимое буфера до границы, которую find_stop(begin,
+// end) находит в очередном куске (или возвращает end). Граница остаётся
+// в потоке; false - поток кончился раньше
+template <typename FindStop>
+bool ReadUntil(std::streambuf* buf, String& str, FindStop find_stop) {
+  using Traits = std::streambuf::traits_type;
+  while (true) {
+    if (StreamBufferAccess::Begin(buf) == StreamBufferAccess::End(buf)) {
+      const int kNext = buf->sgetc();
+      if (Traits::eq_int_type(kNext, Traits::eof())) {
+        return false;
+      }
+      // небуферизованный поток отдаёт по одному символу
+      if (StreamBufferAccess::Begin(buf) == StreamBufferAccess::End(buf)) {
+        const char kChar = Traits::to_char_type(kNext);
+        if (find_stop(&kChar, &kChar + 1) == &kChar) {
+          return true;
+        }
+        str.PushBack(kChar);
+        buf->sbumpc();
+        continue;
+      }
+    }
+    const char* begin = StreamBufferAccess::Begin(buf);
+    const char* end = StreamBufferAccess::End(buf);
+    const char* stop = find_stop(begin, end);
+    str += StringView(begin, stop - begin);
+    StreamBufferAccess::Skip(buf, stop - begin);
+    if (stop != end) {
+      return true;
+    }
+  }
+}
+
 // операторы ввода и вывода
 std::ostream& operator<<(std::ostream& os_out, const String& str) {
-  for (size_t i = 0; i < str.Size(); ++i) {
-    os_out << str[i];
-  }
-  return os_out;
+  return os_out.write(str.Data(), str.Size());
 }
 
+std::ostream& operator<<(std::ostream& os_out, StringView str) {
+  return os_out.write(str.Data(), str.Size());
+}
+
+// ввод читается прямо из буфера streambuf кусками, а не по символу
 std::istream& operator>>(std::istream& input, String& str) {
-  char symbol;
+  std::istream::sentry sentry(input);
+  if (!sentry) {
+    return input;
+  }
+  const auto& ctype = std::use_facet<std::ctype<char>>(input.getloc());
   str.Clear();
-  while (input.get(symbol) && (std::isspace(symbol) == 0)) {
-    str.PushBack(symbol);
+  const bool kFound = ReadUntil(
+      input.rdbuf(), str, [&ctype](const char* begin, const char* end) {
+        return ctype.scan_is(std::ctype_base::space, begin, end);
+      });
+  std::ios::iostate state = kFound ? std::ios::goodbit : std::ios::eofbit;
+  if (str.Empty()) {
+    state |= std::ios::failbit;
   }
+  input.setstate(state);
+  return input;
+}
+
+std::istream& GetLine(std::istream& input, String& str, char delim) {
+  std::istream::sentry sentry(input, true);
+  if (!sentry) {
+    return input;
+  }
+  str.Clear();
+  const bool kFound = ReadUntil(
+      input.rdbuf(), str, [delim](const char* begin, const char* end) {
+        const void* found = memchr(begin, delim, end - begin);
+        return found == nullptr ? end : static_cast<const char*>(found);
+      });
+  if (kFound) {
+    input.rdbuf()->sbumpc();
+    return input;
+  }
+  input.setstate(str.Empty() ? std::ios::eofbit | std::ios::failbit
+                             : std::ios::eofbit);
   return input;
 }
 
 // питоновские методы
-std::vector<String> String::Split(const String& delim) {
+std::vector<String> String::Split(StringView delim) const {
   std::vector<String> result;
-  size_t tmp = 0;
-  int length;
-  String tmp_str;
-  char* tmp_char = string_;
-  while (true) {
-    if (tmp_char == nullptr) {
-      break;
-    }
-    length = strstr(string_ + tmp, delim.string_) - tmp_char;
-    if (length < 0) {
-      result.push_back(tmp_char);
-      return result;
-    }
-    if (length > 0) {
-      tmp_str.Resize(length);
-      memcpy(tmp_str.string_, tmp_char, length);
-      tmp_str.string_[length] = '\0';
-      result.push_back(tmp_str);
-      tmp_char += delim.size_ + length;
-      tmp += delim.size_ + length;
-    }
-    if (length == 0) {
-      result.push_back(String(""));
-      tmp_char += delim.size_ + length;
-      tmp += delim.size_ + length;
-    }
+  Tokenizer tokens(*this, delim);
+  StringView token;
+  while (tokens.Next(token)) {
+    result.emplace_back(token);
+  }
+  return result;
+}
+
+std::vector<StringView> String::SplitView(StringView delim) const {
+  std::vector<StringView> result;
+  Tokenizer tokens(*this, delim);
+  StringView token;
+  while (tokens.Next(token)) {
+    result.push_back(token);
   }
   return result;
 }
 
 String String::Join(const std::vector<String>& strings) const {
-  String result;
+  StringBuilder builder;
+  for (size_t i = 0; i < strings.size(); ++i) {
+    if (i != 0) {
+      builder.Append(*this);
+    }
+    builder.Append(strings[i]);
+  }
+  return builder.Build();
+}
+
+String String::Join(const std::vector<StringView>& strings) const {
+  StringBuilder builder;
   for (size_t i = 0; i < strings.size(); ++i) {
-    result += strings[i];
-    if (i != strings.size() - 1) {
-      result += *this;
+    if (i != 0) {
+      builder.Append(*this);
     }
+    builder.Append(strings[i]);
+  }
+  return builder.Build();
+}
+
+// числа
+bool StringView::ParseDouble(double& value) const {
+  double result;
+  const auto [end, error] = std::from_chars(data_, data_ + size_, result);
+  if (error != std::errc() || end != data_ + size_) {
+    return false;
+  }
+  value = result;
+  return true;
+}
+
+String String::FromDouble(double value) {
+  String result;
+  result.AppendDouble(value);
+  return result;
+}
+
+// кратчайшая запись double не длиннее 24 символов: -1.7976931348623157e+308
+String& String::AppendDouble(double value) {
+  Grow(size_ + 24);
+  size_ = std::to_chars(string_ + size_, string_ + Capacity(), value).ptr -
+          string_;
+  string_[size_] = '\0';
+  return *this;
+}
+
+bool String::ParseDouble(double& value) const {
+  return StringView(*this).ParseDouble(value);
+}
+
+// сборка строки
+StringBuilder& StringBuilder::Append(StringView piece) {
+  pieces_.push_back({piece.Data(), 0, piece.Size()});
+  size_ += piece.Size();
+  return *this;
+}
+
+StringBuilder& StringBuilder::AppendCopy(StringView piece) {
+  pieces_.push_back({nullptr, owned_.Size(), piece.Size()});
+  owned_ += piece;
+  size_ += piece.Size();
+  return *this;
+}
+
+StringBuilder& StringBuilder::Append(char character) {
+  return AppendCopy(StringView(&character, 1));
+}
+
+String StringBuilder::Build(std::pmr::memory_resource* resource) const {
+  String result(resource);
+  result.Reserve(size_);
+  for (const Piece& piece : pieces_) {
+    const char* data =
+        piece.data == nullptr ? owned_.Data() + piece.offset : piece.data;
+    result += StringView(data, piece.size);
   }
   return result;
 }
 
+void StringBuilder::Clear() {
+  pieces_.clear();
+  owned_.Clear();
+  size_ = 0;
+}
+
+// поиск
+size_t StringView::Find(StringView needle, size_t pos) const {
+  if (pos > size_) {
+    return kNpos;
+  }
+  const char* found =
+      FindBytes(data_ + pos, size_ - pos, needle.data_, needle.size_);
+  return found == nullptr ? kNpos : found - data_;
+}
+
+size_t StringView::RFind(StringView needle, size_t pos) const {
+  if (needle.size_ > size_) {
+    return kNpos;
+  }
+  const size_t kStart = std::min(pos, size_ - needle.size_);
+  const char* found =
+      RFindBytes(data_, kStart + needle.size_, needle.data_, needle.size_);
+  return found == nullptr ? kNpos : found - data_;
+}
+
+size_t StringView::FindFirstOf(StringView chars, size_t pos) const {
+  if (pos >= size_) {
+    return kNpos;
+  }
+  if (chars.size_ == 1) {
+    const void* found = memchr(data_ + pos, chars.data_[0], size_ - pos);
+    return found == nullptr ? kNpos : static_cast<const char*>(found) - data_;
+  }
+  bool table[256] = {};
+  for (char character : chars) {
+    table[static_cast<unsigned char>(character)] = true;
+  }
+  for (size_t i = pos; i < size_; ++i) {
+    if (table[static_cast<unsigned char>(data_[i])]) {
+      return i;
+    }
+  }
+  return kNpos;
+}
+
+size_t StringView::Count(StringView needle) const {
+  if (needle.Empty()) {
+    return size_ + 1;
+  }
+  size_t count = 0;
+  for (size_t pos = Find(needle); pos != kNpos;
+       pos = Find(needle, pos + needle.size_)) {
+    ++count;
+  }
+  return count;
+}
+
+size_t String::Find(StringView needle, size_t pos) const {
+  return StringView(*this).Find(needle, pos);
+}
+
+size_t String::RFind(StringView needle, size_t pos) const {
+  return StringView(*this).RFind(needle, pos);
+}
+
+size_t String::FindFirstOf(StringView chars, size_t pos) const {
+  return StringView(*this).FindFirstOf(chars, pos);
+}
+
+bool String::Contains(StringView needle) const {
+  return StringView(*this).Contains(needle);
+}
+
+size_t String::Count(StringView needle) const {
+  return StringView(*this).Count(needle);
+}
+
+// разбор на токены
+bool Tokenizer::Next(StringView& token) {
+  if (done_) {
+    return false;
+  }
+  const char* found = FindBytes(rest_.Data(), rest_.Size(), delim_.Data(),
+                                delim_.Size());
+  if (delim_.Empty() || found == nullptr) {
+    token = rest_;
+    done_ = true;
+    return true;
+  }
+  token = StringView(rest_.Data(), found - rest_.Data());
+  rest_.RemovePrefix(token.Size() + delim_.Size());
+  return true;
+}
+
 // вспомогательные методы написанные ручками
 
 size_t GetRealCap(size_t size) {
@@ -437,20 +977,234 @@ size_t GetRealCap(size_t size) {
   return degre;
 }
 
-// Функции Объявленые вне класса
+// needle_size >= 2: сравниваем сразу блок позиций по первому и последнему
+// байту needle, memcmp только для кандидатов
+const char* FindShortNeedle(const char* haystack, size_t haystack_size,
+                            const char* needle, size_t needle_size) {
+  const size_t kLast = needle_size - 1;
+  size_t pos = 0;
+#if defined(__AVX2__)
+  const __m256i kFirstByte = _mm256_set1_epi8(needle[0]);
+  const __m256i kLastByte = _mm256_set1_epi8(needle[kLast]);
+  for (; pos + kLast + 32 <= haystack_size; pos += 32) {
+    const __m256i kBlockFirst = _mm256_loadu_si256(
+        reinterpret_cast<const __m256i*>(haystack + pos));
+    const __m256i kBlockLast = _mm256_loadu_si256(
+        reinterpret_cast<const __m256i*>(haystack + pos + kLast));
+    uint32_t mask = _mm256_movemask_epi8(
+        _mm256_and_si256(_mm256_cmpeq_epi8(kBlockFirst, kFirstByte),
+                         _mm256_cmpeq_epi8(kBlockLast, kLastByte)));
+#elif defined(__SSE2__)
+  const __m128i kFirstByte = _mm_set1_epi8(needle[0]);
+  const __m128i kLastByte = _mm_set1_epi8(needle[kLast]);
+  for (; pos + kLast + 16 <= haystack_size; pos += 16) {
+    const __m128i kBlockFirst =
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(haystack + pos));
+    const __m128i kBlockLast = _mm_loadu_si128(
+        reinterpret_cast<const __m128i*>(haystack + pos + kLast));
+    uint32_t mask = _mm_movemask_epi8(
+        _mm_and_si128(_mm_cmpeq_epi8(kBlockFirst, kFirstByte),
+                      _mm_cmpeq_epi8(kBlockLast, kLastByte)));
+#endif
+#if defined(__AVX2__) || defined(__SSE2__)
+    while (mask != 0) {
+      const size_t kCandidate = pos + __builtin_ctz(mask);
+      if (memcmp(haystack + kCandidate + 1, needle + 1, kLast - 1) == 0) {
+        return haystack + kCandidate;
+      }
+      mask &= mask - 1;
+    }
+  }
+#endif
+  for (; pos + kLast < haystack_size; ++pos) {
+    if (haystack[pos] == needle[0] && haystack[pos + kLast] == needle[kLast] &&
+        memcmp(haystack + pos + 1, needle + 1, kLast - 1) == 0) {
+      return haystack + pos;
+    }
+  }
+  return nullptr;
+}
 
-int Strcmp(const String& str_1, const String& str_2) {
-  if (str_1.Size() != str_2.Size()) {
-    return (str_1.Size() < str_2.Size()) ? -1 : 1;
+// Бойер-Мур-Хорспул: сдвиг по последнему байту окна
+const char* FindLongNeedle(const char* haystack, size_t haystack_size,
+                           const char* needle, size_t needle_size) {
+  const size_t kLast = needle_size - 1;
+  size_t shift[256];
+  std::fill(shift, shift + 256, needle_size);
+  for (size_t i = 0; i < kLast; ++i) {
+    shift[static_cast<unsigned char>(needle[i])] = kLast - i;
   }
-  size_t str_sum_1 = 0;
-  size_t str_sum_2 = 0;
-  for (size_t i = 0; i < str_1.Size(); ++i) {
-    str_sum_1 += str_1[i] - '0';
-    str_sum_2 += str_2[i] - '0';
+  for (size_t pos = 0; pos + kLast < haystack_size;) {
+    const char kTail = haystack[pos + kLast];
+    if (kTail == needle[kLast] && memcmp(haystack + pos, needle, kLast) == 0) {
+      return haystack + pos;
+    }
+    pos += shift[static_cast<unsigned char>(kTail)];
   }
-  if (str_sum_1 != str_sum_2) {
-    return (str_sum_1 < str_sum_2) ? -1 : 1;
+  return nullptr;
+}
+
+const char* FindBytes(const char* haystack, size_t haystack_size,
+                      const char* needle, size_t needle_size) {
+  if (needle_size == 0) {
+    return haystack;
+  }
+  if (needle_size > haystack_size) {
+    return nullptr;
+  }
+  if (needle_size == 1) {
+    return static_cast<const char*>(memchr(haystack, needle[0], haystack_size));
+  }
+  if (needle_size < kLongNeedleSize) {
+    return FindShortNeedle(haystack, haystack_size, needle, needle_size);
+  }
+  return FindLongNeedle(haystack, haystack_size, needle, needle_size);
+}
+
+// кандидаты [0, end) проверяются блоками с конца, в блоке - от старшего
+// бита маски к младшему
+const char* RFindBytes(const char* haystack, size_t haystack_size,
+                       const char* needle, size_t needle_size) {
+  if (needle_size > haystack_size) {
+    return nullptr;
+  }
+  if (needle_size == 0) {
+    return haystack + haystack_size;
+  }
+  const size_t kLast = needle_size - 1;
+  size_t end = haystack_size - kLast;
+#if defined(__AVX2__)
+  const __m256i kFirstByte = _mm256_set1_epi8(needle[0]);
+  const __m256i kLastByte = _mm256_set1_epi8(needle[kLast]);
+  for (; end >= 32; end -= 32) {
+    const size_t kPos = end - 32;
+    const __m256i kBlockFirst = _mm256_loadu_si256(
+        reinterpret_cast<const __m256i*>(haystack + kPos));
+    const __m256i kBlockLast = _mm256_loadu_si256(
+        reinterpret_cast<const __m256i*>(haystack + kPos + kLast));
+    uint32_t mask = _mm256_movemask_epi8(
+        _mm256_and_si256(_mm256_cmpeq_epi8(kBlockFirst, kFirstByte),
+                         _mm256_cmpeq_epi8(kBlockLast, kLastByte)));
+#elif defined(__SSE2__)
+  const __m128i kFirstByte = _mm_set1_epi8(needle[0]);
+  const __m128i kLastByte = _mm_set1_epi8(needle[kLast]);
+  for (; end >= 16; end -= 16) {
+    const size_t kPos = end - 16;
+    const __m128i kBlockFirst =
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(haystack + kPos));
+    const __m128i kBlockLast = _mm_loadu_si128(
+        reinterpret_cast<const __m128i*>(haystack + kPos + kLast));
+    uint32_t mask = _mm_movemask_epi8(
+        _mm_and_si128(_mm_cmpeq_epi8(kBlockFirst, kFirstByte),
+                      _mm_cmpeq_epi8(kBlockLast, kLastByte)));
+#endif
+#if defined(__AVX2__) || defined(__SSE2__)
+    while (mask != 0) {
+      const size_t kCandidate = kPos + 31 - __builtin_clz(mask);
+      if (memcmp(haystack + kCandidate, needle, kLast) == 0) {
+        return haystack + kCandidate;
+      }
+      mask ^= 1u << (kCandidate - kPos);
+    }
+  }
+#endif
+  while (end-- > 0) {
+    if (haystack[end + kLast] == needle[kLast] &&
+        memcmp(haystack + end, needle, kLast) == 0) {
+      return haystack + end;
+    }
+  }
+  return nullptr;
+}
+
+// хеширование
+const uint64_t kHashSecret[4] = {0xa0761d6478bd642fULL, 0xe7037ed1a0b428dbULL,
+                                 0x8ebc6af09c88c6e3ULL, 0x589965cc75374cc3ULL};
+
+// перемешивание: xor старшей и младшей половин 128-битного произведения
+uint64_t HashMix(uint64_t lhs, uint64_t rhs) {
+  const unsigned __int128 kProduct =
+      static_cast<unsigned __int128>(lhs) * rhs;
+  return static_cast<uint64_t>(kProduct) ^
+         static_cast<uint64_t>(kProduct >> 64);
+}
+
+uint64_t LoadWord(const char* data) {
+  uint64_t word;
+  memcpy(&word, data, sizeof(word));
+  return word;
+}
+
+uint64_t LoadHalfWord(const char* data) {
+  uint32_t word;
+  memcpy(&word, data, sizeof(word));
+  return word;
+}
+
+uint64_t HashBytes(const char* data, size_t size, uint64_t seed) {
+  seed ^= HashMix(seed ^ kHashSecret[0], kHashSecret[1]);
+  uint64_t word_1 = 0;
+  uint64_t word_2 = 0;
+  if (size <= 16) {
+    if (size >= 4) {
+      const size_t kShift = (size >> 3) << 2;
+      word_1 = (LoadHalfWord(data) << 32) | LoadHalfWord(data + kShift);
+      word_2 = (LoadHalfWord(data + size - 4) << 32) |
+               LoadHalfWord(data + size - 4 - kShift);
+    } else if (size > 0) {
+      word_1 = (uint64_t(uint8_t(data[0])) << 16) |
+               (uint64_t(uint8_t(data[size >> 1])) << 8) |
+               uint8_t(data[size - 1]);
+    }
+  } else {
+    size_t rest = size;
+    if (rest > 48) {
+      uint64_t seed_1 = seed;
+      uint64_t seed_2 = seed;
+      do {
+        seed = HashMix(LoadWord(data) ^ kHashSecret[1],
+                       LoadWord(data + 8) ^ seed);
+        seed_1 = HashMix(LoadWord(data + 16) ^ kHashSecret[2],
+                         LoadWord(data + 24) ^ seed_1);
+        seed_2 = HashMix(LoadWord(data + 32) ^ kHashSecret[3],
+                         LoadWord(data + 40) ^ seed_2);
+        data += 48;
+        rest -= 48;
+      } while (rest > 48);
+      seed ^= seed_1 ^ seed_2;
+    }
+    while (rest > 16) {
+      seed =
+          HashMix(LoadWord(data) ^ kHashSecret[1], LoadWord(data + 8) ^ seed);
+      data += 16;
+      rest -= 16;
+    }
+    word_1 = LoadWord(data + rest - 16);
+    word_2 = LoadWord(data + rest - 8);
+  }
+  const unsigned __int128 kProduct =
+      static_cast<unsigned __int128>(word_1 ^ kHashSecret[1]) *
+      (word_2 ^ seed);
+  return HashMix(static_cast<uint64_t>(kProduct) ^ kHashSecret[0] ^ size,
+                 static_cast<uint64_t>(kProduct >> 64) ^ kHashSecret[1]);
+}
+
+// Функции Объявленые вне класса
+
+// общий префикс сравнивает memcmp (в libc он векторизован), при равном
+// префиксе меньше более короткая строка
+int Compare(StringView str_1, StringView str_2) {
+  const int kRes = memcmp(str_1.Data(), str_2.Data(),
+                          std::min(str_1.Size(), str_2.Size()));
+  if (kRes != 0) {
+    return kRes;
+  }
+  if (str_1.Size() != str_2.Size()) {
+    return str_1.Size() < str_2.Size() ? -1 : 1;
   }
   return 0;
 }
+
+int Strcmp(const String& str_1, const String& str_2) {
+  return Compare(str_1, str_2);
+}
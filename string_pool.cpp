@@ -0,0 +1,217 @@
+#pragma once
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <vector>
+
+#include "string.hpp"
+
+const size_t kPoolShards = 16;  // независимые мьютексы против конкуренции
+const size_t kPoolChunkSize = 1 << 16;  // строки копируются в такие куски
+
+// заголовок строки в арене, байты строки с '\0' лежат сразу за ним
+struct InternedEntry {
+  uint64_t hash;
+  size_t size;
+
+  const char* Data() const { return reinterpret_cast<const char*>(this + 1); }
+};
+
+// дескриптор строки из пула: один указатель. Равные строки одного пула
+// имеют один и тот же дескриптор, поэтому сравнение и хеш не читают байты
+class InternedString {
+ public:
+  InternedString();  // пустая строка
+
+  const char* Data() const { return entry_->Data(); }
+  size_t Size() const { return entry_->size; }
+  bool Empty() const { return entry_->size == 0; }
+  StringView View() const { return StringView(Data(), Size()); }
+  operator StringView() const { return View(); }
+
+  bool operator==(InternedString other) const {
+    return entry_ == other.entry_;
+  }
+  bool operator!=(InternedString other) const {
+    return entry_ != other.entry_;
+  }
+  size_t PointerHash() const {
+    return reinterpret_cast<uintptr_t>(entry_) * 0x9e3779b97f4a7c15ULL;
+  }
+
+ private:
+  friend class StringPool;
+
+  explicit InternedString(const InternedEntry* entry) : entry_(entry) {}
+
+  const InternedEntry* entry_;
+};
+
+namespace std {
+template <>
+struct hash<InternedString> {
+  size_t operator()(InternedString str) const { return str.PointerHash(); }
+};
+}  // namespace std
+
+// потокобезопасный пул уникальных строк. Содержимое копируется в арену
+// один раз и живёт, пока жив пул; шард выбирается по хешу, так что потоки
+// с разными строками редко ждут друг друга
+class StringPool {
+ public:
+  StringPool() = default;
+  StringPool(const StringPool&) = delete;
+  StringPool& operator=(const StringPool&) = delete;
+
+  InternedString Intern(StringView str);
+
+  size_t Size() const;         // число различных строк
+  size_t MemoryUsage() const;  // байты арены и таблиц
+
+ private:
+  struct Shard {
+    mutable std::mutex mutex;
+    std::vector<std::unique_ptr<char[]>> chunks;  // заполняется последний
+    std::vector<std::unique_ptr<char[]>> large;   // по одной большой строке
+    size_t chunk_used = kPoolChunkSize;
+    // открытая адресация, размер - степень двойки
+    std::vector<const InternedEntry*> table;
+    size_t count = 0;
+    size_t arena_bytes = 0;
+  };
+
+  static const InternedEntry* Find(const Shard& shard, StringView str,
+                                   uint64_t hash);
+  static const InternedEntry* Insert(Shard& shard, StringView str,
+                                     uint64_t hash);
+  static char* Allocate(Shard& shard, size_t bytes);
+
+  Shard shards_[kPoolShards];
+};
+
+// общий пул процесса
+StringPool& GlobalStringPool();
+InternedString Intern(StringView str);
+
+#include "string_pool.hpp"
+
+// пустая строка общая для всех пулов, чтобы дескриптор по умолчанию
+// был корректным без выделения памяти
+struct EmptyInternedEntry {
+  InternedEntry header{HashBytes("", 0), 0};
+  char terminator = '\0';
+};
+
+const EmptyInternedEntry kEmptyInternedEntry;
+
+InternedString::InternedString() : entry_(&kEmptyInternedEntry.header) {}
+
+InternedString StringPool::Intern(StringView str) {
+  if (str.Empty()) {
+    return InternedString();
+  }
+  const uint64_t kHash = HashBytes(str.Data(), str.Size());
+  Shard& shard = shards_[(kHash >> 56) % kPoolShards];
+  std::lock_guard<std::mutex> lock(shard.mutex);
+  const InternedEntry* entry = Find(shard, str, kHash);
+  if (entry == nullptr) {
+    entry = Insert(shard, str, kHash);
+  }
+  return InternedString(entry);
+}
+
+size_t StringPool::Size() const {
+  size_t count = 0;
+  for (const Shard& shard : shards_) {
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    count += shard.count;
+  }
+  return count;
+}
+
+size_t StringPool::MemoryUsage() const {
+  size_t bytes = 0;
+  for (const Shard& shard : shards_) {
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    bytes += shard.arena_bytes +
+             shard.table.capacity() * sizeof(const InternedEntry*);
+  }
+  return bytes;
+}
+
+const InternedEntry* StringPool::Find(const Shard& shard, StringView str,
+                                      uint64_t hash) {
+  if (shard.table.empty()) {
+    return nullptr;
+  }
+  const size_t kMask = shard.table.size() - 1;
+  for (size_t pos = hash & kMask;; pos = (pos + 1) & kMask) {
+    const InternedEntry* entry = shard.table[pos];
+    if (entry == nullptr) {
+      return nullptr;
+    }
+    if (entry->hash == hash && entry->size == str.Size() &&
+        memcmp(entry->Data(), str.Data(), str.Size()) == 0) {
+      return entry;
+    }
+  }
+}
+
+const InternedEntry* StringPool::Insert(Shard& shard, StringView str,
+                                        uint64_t hash) {
+  // заполненность таблицы не выше половины
+  if (2 * (shard.count + 1) > shard.table.size()) {
+    std::vector<const InternedEntry*> table(
+        std::max<size_t>(64, 2 * shard.table.size()), nullptr);
+    const size_t kMask = table.size() - 1;
+    for (const InternedEntry* entry : shard.table) {
+      if (entry != nullptr) {
+        size_t pos = entry->hash & kMask;
+        while (table[pos] != nullptr) {
+          pos = (pos + 1) & kMask;
+        }
+        table[pos] = entry;
+      }
+    }
+    shard.table.swap(table);
+  }
+  char* memory = Allocate(shard, sizeof(InternedEntry) + str.Size() + 1);
+  InternedEntry* entry = new (memory) InternedEntry{hash, str.Size()};
+  memcpy(memory + sizeof(InternedEntry), str.Data(), str.Size());
+  memory[sizeof(InternedEntry) + str.Size()] = '\0';
+
+  const size_t kMask = shard.table.size() - 1;
+  size_t pos = hash & kMask;
+  while (shard.table[pos] != nullptr) {
+    pos = (pos + 1) & kMask;
+  }
+  shard.table[pos] = entry;
+  ++shard.count;
+  return entry;
+}
+
+// байты выравниваются под заголовок; большие строки получают свой кусок
+char* StringPool::Allocate(Shard& shard, size_t bytes) {
+  bytes = (bytes + alignof(InternedEntry) - 1) & ~(alignof(InternedEntry) - 1);
+  if (bytes > kPoolChunkSize / 4) {
+    shard.large.emplace_back(new char[bytes]);
+    shard.arena_bytes += bytes;
+    return shard.large.back().get();
+  }
+  if (shard.chunk_used + bytes > kPoolChunkSize) {
+    shard.chunks.emplace_back(new char[kPoolChunkSize]);
+    shard.arena_bytes += kPoolChunkSize;
+    shard.chunk_used = 0;
+  }
+  char* memory = shard.chunks.back().get() + shard.chunk_used;
+  shard.chunk_used += bytes;
+  return memory;
+}
+
+StringPool& GlobalStringPool() {
+  static StringPool pool;
+  return pool;
+}
+
+InternedString Intern(StringView str) { return GlobalStringPool().Intern(str); }
@@ -0,0 +1,182 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+#include "string.hpp"
+
+// на меньших кусках быстрее обычная сортировка сравнениями
+const size_t kSortInsertionThreshold = 32;
+// при меньшем числе строк потоки не окупаются
+const size_t kSortParallelThreshold = 1 << 16;
+
+// лексикографическая сортировка (как Compare) многоключевой быстрой
+// сортировкой. Ключ - очередные 8 байт строки, заранее прочитанные в
+// массив рядом с указателем на строку, поэтому разбиение не ходит по
+// указателям и не сравнивает уже совпавшие префиксы заново
+void SortStrings(std::vector<String>& strings);
+// то же, но строки сначала раскладываются по первым двум байтам, а
+// корзины сортируются параллельно; threads == 0 - по числу ядер
+void SortStringsParallel(std::vector<String>& strings, size_t threads = 0);
+
+#include "string_sort.hpp"
+
+// chunk - 8 байт строки с позиции depth в порядке big-endian, дополненные
+// нулями; avail - сколько из них настоящие. Порядок пар (chunk, avail)
+// совпадает с лексикографическим порядком строк с одинаковыми первыми
+// depth байтами, в том числе для строк с '\0' внутри
+struct SortKey {
+  uint64_t chunk;
+  size_t avail;
+  String* str;
+};
+
+bool KeyLess(const SortKey& lhs, const SortKey& rhs) {
+  return lhs.chunk < rhs.chunk ||
+         (lhs.chunk == rhs.chunk && lhs.avail < rhs.avail);
+}
+
+bool KeyEqual(const SortKey& lhs, const SortKey& rhs) {
+  return lhs.chunk == rhs.chunk && lhs.avail == rhs.avail;
+}
+
+void LoadKeys(SortKey* begin, SortKey* end, size_t depth) {
+  for (SortKey* key = begin; key != end; ++key) {
+    const size_t kSize = key->str->Size();
+    key->avail = kSize > depth ? std::min<size_t>(kSize - depth, 8) : 0;
+    uint64_t chunk = 0;
+    memcpy(&chunk, key->str->Data() + std::min(depth, kSize), key->avail);
+    key->chunk = __builtin_bswap64(chunk);
+  }
+}
+
+// ключи на глубине depth уже загружены
+void MultikeySort(SortKey* begin, SortKey* end, size_t depth) {
+  while (end - begin > 1) {
+    if (static_cast<size_t>(end - begin) < kSortInsertionThreshold) {
+      std::sort(begin, end, [depth](const SortKey& lhs, const SortKey& rhs) {
+        if (!KeyEqual(lhs, rhs)) {
+          return KeyLess(lhs, rhs);
+        }
+        return lhs.avail == 8 &&
+               Compare(StringView(*lhs.str).Substr(depth + 8),
+                       StringView(*rhs.str).Substr(depth + 8)) < 0;
+      });
+      return;
+    }
+    // медиана трёх
+    SortKey* middle = begin + (end - begin) / 2;
+    SortKey* last = end - 1;
+    if (KeyLess(*middle, *begin)) {
+      std::swap(*middle, *begin);
+    }
+    if (KeyLess(*last, *middle)) {
+      std::swap(*last, *middle);
+      if (KeyLess(*middle, *begin)) {
+        std::swap(*middle, *begin);
+      }
+    }
+    const SortKey kPivot = *middle;
+    // трёхчастное разбиение: [begin, less) < pivot, [greater, end) > pivot
+    SortKey* less = begin;
+    SortKey* greater = end;
+    for (SortKey* cur = begin; cur < greater;) {
+      if (KeyLess(*cur, kPivot)) {
+        std::swap(*cur++, *less++);
+      } else if (KeyLess(kPivot, *cur)) {
+        std::swap(*cur, *--greater);
+      } else {
+        ++cur;
+      }
+    }
+    MultikeySort(begin, less, depth);
+    MultikeySort(greater, end, depth);
+    // равные ключи: строки закончились вместе или сравниваются дальше
+    if (kPivot.avail < 8) {
+      return;
+    }
+    begin = less;
+    end = greater;
+    depth += 8;
+    LoadKeys(begin, end, depth);
+  }
+}
+
+// переставляет строки в порядке ключей; перемещение String дешёвое
+void ApplyOrder(std::vector<String>& strings,
+                const std::vector<SortKey>& keys) {
+  std::vector<String> sorted;
+  sorted.reserve(strings.size());
+  for (const SortKey& key : keys) {
+    sorted.push_back(std::move(*key.str));
+  }
+  strings.swap(sorted);
+}
+
+std::vector<SortKey> MakeKeys(std::vector<String>& strings) {
+  std::vector<SortKey> keys(strings.size());
+  for (size_t i = 0; i < strings.size(); ++i) {
+    keys[i].str = &strings[i];
+  }
+  LoadKeys(keys.data(), keys.data() + keys.size(), 0);
+  return keys;
+}
+
+void SortStrings(std::vector<String>& strings) {
+  std::vector<SortKey> keys = MakeKeys(strings);
+  MultikeySort(keys.data(), keys.data() + keys.size(), 0);
+  ApplyOrder(strings, keys);
+}
+
+void SortStringsParallel(std::vector<String>& strings, size_t threads) {
+  if (threads == 0) {
+    threads = std::thread::hardware_concurrency();
+  }
+  if (strings.size() < kSortParallelThreshold || threads <= 1) {
+    SortStrings(strings);
+    return;
+  }
+  std::vector<SortKey> keys = MakeKeys(strings);
+  // раскладка подсчётом по старшим 16 битам ключа: порядок корзин
+  // совпадает с порядком строк
+  const size_t kBuckets = 1 << 16;
+  std::vector<size_t> offsets(kBuckets + 1, 0);
+  for (const SortKey& key : keys) {
+    ++offsets[(key.chunk >> 48) + 1];
+  }
+  for (size_t i = 0; i < kBuckets; ++i) {
+    offsets[i + 1] += offsets[i];
+  }
+  std::vector<SortKey> bucketed(keys.size());
+  std::vector<size_t> fill(offsets.begin(), offsets.end() - 1);
+  for (const SortKey& key : keys) {
+    bucketed[fill[key.chunk >> 48]++] = key;
+  }
+  // большие корзины раздаются первыми, чтобы потоки закончили вместе
+  std::vector<size_t> order;
+  for (size_t i = 0; i < kBuckets; ++i) {
+    if (offsets[i + 1] - offsets[i] > 1) {
+      order.push_back(i);
+    }
+  }
+  std::sort(order.begin(), order.end(), [&offsets](size_t lhs, size_t rhs) {
+    return offsets[lhs + 1] - offsets[lhs] > offsets[rhs + 1] - offsets[rhs];
+  });
+  std::atomic<size_t> next(0);
+  auto worker = [&]() {
+    for (size_t i = next++; i < order.size(); i = next++) {
+      MultikeySort(bucketed.data() + offsets[order[i]],
+                   bucketed.data() + offsets[order[i] + 1], 0);
+    }
+  };
+  std::vector<std::thread> pool;
+  for (size_t i = 1; i < threads; ++i) {
+    pool.emplace_back(worker);
+  }
+  worker();
+  for (auto& thread : pool) {
+    thread.join();
+  }
+  ApplyOrder(strings, bucketed);
+}
@@ -0,0 +1,282 @@
+#pragma once
+#include <cstdint>
+
+#include "string.hpp"
+
+// кодировка и регистр. Регистр меняется только у латиницы A-Z/a-z, прочие
+// байты (в том числе многобайтовые символы UTF-8) остаются как есть
+
+// строгая проверка UTF-8: без overlong-форм, суррогатов и символов
+// за U+10FFFF
+bool IsValidUtf8(StringView str);
+// число символов UTF-8 - байтов, не являющихся продолжением (10xxxxxx)
+size_t CountCodePoints(StringView str);
+
+String ToLowerAscii(StringView str);
+String ToUpperAscii(StringView str);
+void ToLowerAsciiInPlace(String& str);
+void ToUpperAsciiInPlace(String& str);
+
+// сравнение и поиск без учёта регистра латиницы
+int CompareIgnoreCase(StringView str_1, StringView str_2);
+bool EqualsIgnoreCase(StringView str_1, StringView str_2);
+size_t FindIgnoreCase(StringView haystack, StringView needle, size_t pos = 0);
+
+#include "string_utf8.hpp"
+
+// блоки байтов: одинаковые операции для AVX2 и SSE2
+#if defined(__AVX2__)
+using ByteBlock = __m256i;
+const size_t kBlockSize = 32;
+const uint32_t kFullMask = 0xffffffff;
+
+ByteBlock LoadBlock(const char* data) {
+  return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data));
+}
+void StoreBlock(char* data, ByteBlock block) {
+  _mm256_storeu_si256(reinterpret_cast<__m256i*>(data), block);
+}
+ByteBlock SplatByte(char byte) { return _mm256_set1_epi8(byte); }
+ByteBlock EqualBytes(ByteBlock lhs, ByteBlock rhs) {
+  return _mm256_cmpeq_epi8(lhs, rhs);
+}
+ByteBlock GreaterBytes(ByteBlock lhs, ByteBlock rhs) {
+  return _mm256_cmpgt_epi8(lhs, rhs);
+}
+ByteBlock AddBytes(ByteBlock lhs, ByteBlock rhs) {
+  return _mm256_add_epi8(lhs, rhs);
+}
+ByteBlock AndBlocks(ByteBlock lhs, ByteBlock rhs) {
+  return _mm256_and_si256(lhs, rhs);
+}
+ByteBlock XorBlocks(ByteBlock lhs, ByteBlock rhs) {
+  return _mm256_xor_si256(lhs, rhs);
+}
+uint32_t ByteMask(ByteBlock block) { return _mm256_movemask_epi8(block); }
+#elif defined(__SSE2__)
+using ByteBlock = __m128i;
+const size_t kBlockSize = 16;
+const uint32_t kFullMask = 0xffff;
+
+ByteBlock LoadBlock(const char* data) {
+  return _mm_loadu_si128(reinterpret_cast<const __m128i*>(data));
+}
+void StoreBlock(char* data, ByteBlock block) {
+  _mm_storeu_si128(reinterpret_cast<__m128i*>(data), block);
+}
+ByteBlock SplatByte(char byte) { return _mm_set1_epi8(byte); }
+ByteBlock EqualBytes(ByteBlock lhs, ByteBlock rhs) {
+  return _mm_cmpeq_epi8(lhs, rhs);
+}
+ByteBlock GreaterBytes(ByteBlock lhs, ByteBlock rhs) {
+  return _mm_cmpgt_epi8(lhs, rhs);
+}
+ByteBlock AddBytes(ByteBlock lhs, ByteBlock rhs) {
+  return _mm_add_epi8(lhs, rhs);
+}
+ByteBlock AndBlocks(ByteBlock lhs, ByteBlock rhs) {
+  return _mm_and_si128(lhs, rhs);
+}
+ByteBlock XorBlocks(ByteBlock lhs, ByteBlock rhs) {
+  return _mm_xor_si128(lhs, rhs);
+}
+uint32_t ByteMask(ByteBlock block) { return _mm_movemask_epi8(block); }
+#endif
+
+// байты из [first, first + 25] меняют регистр
+char FlipCaseChar(char character, char first) {
+  return uint8_t(character - first) < 26 ? character ^ 0x20 : character;
+}
+
+char LowerAsciiChar(char character) { return FlipCaseChar(character, 'A'); }
+
+#if defined(__AVX2__) || defined(__SSE2__)
+// диапазон сдвигается к -128, чтобы проверить его одним знаковым сравнением
+ByteBlock FlipCaseBlock(ByteBlock block, char first) {
+  const ByteBlock kShifted = AddBytes(block, SplatByte(char(-128 - first)));
+  const ByteBlock kInRange = GreaterBytes(SplatByte(char(-128 + 26)), kShifted);
+  return XorBlocks(block, AndBlocks(kInRange, SplatByte(0x20)));
+}
+
+ByteBlock LowerAsciiBlock(ByteBlock block) { return FlipCaseBlock(block, 'A'); }
+#endif
+
+void FlipCase(const char* src, char* dst, size_t size, char first) {
+  size_t pos = 0;
+#if defined(__AVX2__) || defined(__SSE2__)
+  for (; pos + kBlockSize <= size; pos += kBlockSize) {
+    StoreBlock(dst + pos, FlipCaseBlock(LoadBlock(src + pos), first));
+  }
+#endif
+  for (; pos < size; ++pos) {
+    dst[pos] = FlipCaseChar(src[pos], first);
+  }
+}
+
+// длина корректной последовательности UTF-8 в начале data или 0
+size_t Utf8SequenceSize(const uint8_t* data, size_t size) {
+  const uint8_t kLead = data[0];
+  if (kLead < 0x80) {
+    return 1;
+  }
+  size_t length;
+  uint8_t low = 0x80;  // границы второго байта
+  uint8_t high = 0xbf;
+  if (kLead >= 0xc2 && kLead <= 0xdf) {
+    length = 2;
+  } else if (kLead >= 0xe0 && kLead <= 0xef) {
+    length = 3;
+    low = kLead == 0xe0 ? 0xa0 : low;    // overlong
+    high = kLead == 0xed ? 0x9f : high;  // суррогаты
+  } else if (kLead >= 0xf0 && kLead <= 0xf4) {
+    length = 4;
+    low = kLead == 0xf0 ? 0x90 : low;    // overlong
+    high = kLead == 0xf4 ? 0x8f : high;  // за U+10FFFF
+  } else {
+    return 0;
+  }
+  if (size < length || data[1] < low || data[1] > high) {
+    return 0;
+  }
+  for (size_t i = 2; i < length; ++i) {
+    if ((data[i] & 0xc0) != 0x80) {
+      return 0;
+    }
+  }
+  return length;
+}
+
+// кодировка
+// блоки из одного ASCII пропускаются целиком, разбор идёт только там,
+// где встретился байт со старшим битом
+bool IsValidUtf8(StringView str) {
+  const uint8_t* data = reinterpret_cast<const uint8_t*>(str.Data());
+  size_t pos = 0;
+  while (pos < str.Size()) {
+#if defined(__AVX2__) || defined(__SSE2__)
+    if (pos + kBlockSize <= str.Size() &&
+        ByteMask(LoadBlock(str.Data() + pos)) == 0) {
+      pos += kBlockSize;
+      continue;
+    }
+#endif
+    const size_t kLength = Utf8SequenceSize(data + pos, str.Size() - pos);
+    if (kLength == 0) {
+      return false;
+    }
+    pos += kLength;
+  }
+  return true;
+}
+
+// байты продолжения 0x80..0xbf - это ровно знаковые [-128, -65]
+size_t CountCodePoints(StringView str) {
+  size_t count = 0;
+  size_t pos = 0;
+#if defined(__AVX2__) || defined(__SSE2__)
+  const ByteBlock kContinuationMax = SplatByte(char(-65));
+  for (; pos + kBlockSize <= str.Size(); pos += kBlockSize) {
+    count += __builtin_popcount(
+        ByteMask(GreaterBytes(LoadBlock(str.Data() + pos), kContinuationMax)));
+  }
+#endif
+  for (; pos < str.Size(); ++pos) {
+    count += static_cast<signed char>(str[pos]) > -65;
+  }
+  return count;
+}
+
+// регистр
+String ToLowerAscii(StringView str) {
+  String result(str);
+  ToLowerAsciiInPlace(result);
+  return result;
+}
+
+String ToUpperAscii(StringView str) {
+  String result(str);
+  ToUpperAsciiInPlace(result);
+  return result;
+}
+
+void ToLowerAsciiInPlace(String& str) {
+  FlipCase(str.Data(), str.Data(), str.Size(), 'A');
+}
+
+void ToUpperAsciiInPlace(String& str) {
+  FlipCase(str.Data(), str.Data(), str.Size(), 'a');
+}
+
+// сравнение без учёта регистра
+int CompareIgnoreCase(StringView str_1, StringView str_2) {
+  const size_t kCommon = std::min(str_1.Size(), str_2.Size());
+  size_t pos = 0;
+#if defined(__AVX2__) || defined(__SSE2__)
+  for (; pos + kBlockSize <= kCommon; pos += kBlockSize) {
+    const uint32_t kDiff =
+        ByteMask(EqualBytes(LowerAsciiBlock(LoadBlock(str_1.Data() + pos)),
+                            LowerAsciiBlock(LoadBlock(str_2.Data() + pos)))) ^
+        kFullMask;
+    if (kDiff != 0) {
+      pos += __builtin_ctz(kDiff);
+      break;
+    }
+  }
+#endif
+  for (; pos < kCommon; ++pos) {
+    const uint8_t kChar1 = LowerAsciiChar(str_1[pos]);
+    const uint8_t kChar2 = LowerAsciiChar(str_2[pos]);
+    if (kChar1 != kChar2) {
+      return kChar1 < kChar2 ? -1 : 1;
+    }
+  }
+  if (str_1.Size() != str_2.Size()) {
+    return str_1.Size() < str_2.Size() ? -1 : 1;
+  }
+  return 0;
+}
+
+bool EqualsIgnoreCase(StringView str_1, StringView str_2) {
+  return str_1.Size() == str_2.Size() && CompareIgnoreCase(str_1, str_2) == 0;
+}
+
+// тот же фильтр по первому и последнему байту, что и в FindBytes, но
+// по блокам, приведённым к нижнему регистру
+size_t FindIgnoreCase(StringView haystack, StringView needle, size_t pos) {
+  if (pos > haystack.Size() || needle.Size() > haystack.Size() - pos) {
+    return kNpos;
+  }
+  if (needle.Empty()) {
+    return pos;
+  }
+  const size_t kLast = needle.Size() - 1;
+  const char kFirstChar = LowerAsciiChar(needle.Front());
+  const char kLastChar = LowerAsciiChar(needle.Back());
+  const char* data = haystack.Data();
+#if defined(__AVX2__) || defined(__SSE2__)
+  const ByteBlock kFirstByte = SplatByte(kFirstChar);
+  const ByteBlock kLastByte = SplatByte(kLastChar);
+  for (; pos + kLast + kBlockSize <= haystack.Size(); pos += kBlockSize) {
+    uint32_t mask = ByteMask(AndBlocks(
+        EqualBytes(LowerAsciiBlock(LoadBlock(data + pos)), kFirstByte),
+        EqualBytes(LowerAsciiBlock(LoadBlock(data + pos + kLast)),
+                   kLastByte)));
+    while (mask != 0) {
+      const size_t kCandidate = pos + __builtin_ctz(mask);
+      if (EqualsIgnoreCase(haystack.Substr(kCandidate, needle.Size()),
+                           needle)) {
+        return kCandidate;
+      }
+      mask &= mask - 1;
+    }
+  }
+#endif
+  for (; pos + kLast < haystack.Size(); ++pos) {
+    if (LowerAsciiChar(data[pos]) == kFirstChar &&
+        LowerAsciiChar(data[pos + kLast]) == kLastChar &&
+        EqualsIgnoreCase(haystack.Substr(pos, needle.Size()), needle)) {
+      return pos;
+    }
+  }
+  return kNpos;
+}